@@ -0,0 +1,85 @@
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nordic_common.h"
+#include "app_error.h"
+#include "evt_queue.h"
+#include "common/mible_beacon.h"
+#include "mible_log.h"
+#include "bin_log.h"
+#include "adv_sched.h"
+
+#define ADV_SCHED_STEP_SLACK_MS         (ADV_SCHED_STEP_MS / 4)
+
+static volatile bool m_connected;
+static uint16_t      m_interval_ms;
+
+static void adv_interval_apply(uint16_t interval_ms)
+{
+    if (m_connected || interval_ms == m_interval_ms)
+        return;
+
+    /* Advertising may also have been restarted by the mijia library, e.g. after a disconnect. */
+    mibeacon_adv_stop();
+    mibeacon_adv_start(interval_ms);
+    m_interval_ms = interval_ms;
+    MI_LOG_DEBUG("adv interval %d ms\n", interval_ms);
+}
+
+static void backoff_handler(void * p_context)
+{
+    /* A connection may have been set up after this step was dispatched. */
+    if (m_connected || m_interval_ms == 0)
+        return;
+
+    uint16_t next = MIN(m_interval_ms * 2, ADV_SCHED_IDLE_INTERVAL_MS);
+
+    adv_interval_apply(next);
+    if (next < ADV_SCHED_IDLE_INTERVAL_MS) {
+        ret_code_t err_code = evt_post_delayed(backoff_handler, NULL, EVT_PRIO_LOW,
+                                               ADV_SCHED_STEP_MS, ADV_SCHED_STEP_SLACK_MS);
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+static void burst_handler(void * p_context)
+{
+    if (m_connected)
+        return;
+
+    adv_interval_apply(ADV_SCHED_FAST_INTERVAL_MS);
+    /* Reschedules a pending step, so repeated kicks extend the burst. */
+    ret_code_t err_code = evt_post_delayed(backoff_handler, NULL, EVT_PRIO_LOW,
+                                           ADV_SCHED_STEP_MS, ADV_SCHED_STEP_SLACK_MS);
+    APP_ERROR_CHECK(err_code);
+}
+
+void adv_sched_start(void)
+{
+    adv_sched_kick();
+}
+
+void adv_sched_kick(void)
+{
+    ret_code_t err_code = evt_post(burst_handler, NULL, EVT_PRIO_HIGH);
+    if (err_code != NRF_SUCCESS)
+        MI_LOG_WARNING("adv burst dropped: %d\n", err_code);
+}
+
+void adv_sched_conn_state_set(bool connected)
+{
+    m_connected = connected;
+    if (connected) {
+        /* The SoftDevice stopped advertising when the connection was established. */
+        evt_cancel(backoff_handler, NULL);
+        m_interval_ms = 0;
+    } else {
+        adv_sched_kick();
+    }
+}
+
+uint16_t adv_sched_interval_get(void)
+{
+    return m_interval_ms;
+}
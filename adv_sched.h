@@ -0,0 +1,45 @@
+/**@file
+ *
+ * @brief Adaptive advertising interval.
+ *
+ * @details Advertising runs at a slow idle interval. An event the gateway should learn about
+ *          quickly, e.g. the bind button or a disconnect, starts a burst at the fast interval.
+ *          The interval is then doubled every ADV_SCHED_STEP_MS until it is back at the idle
+ *          interval. Kicks while connected are ignored, advertising is off then. Interval changes
+ *          restart advertising from the main loop, so the functions below may be called from any
+ *          context.
+ */
+#ifndef ADV_SCHED_H__
+#define ADV_SCHED_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdk_errors.h"
+
+#ifndef ADV_SCHED_FAST_INTERVAL_MS
+#define ADV_SCHED_FAST_INTERVAL_MS      40                                      /**< Interval during a burst. */
+#endif
+#ifndef ADV_SCHED_IDLE_INTERVAL_MS
+#define ADV_SCHED_IDLE_INTERVAL_MS      1000                                    /**< Interval once the backoff is complete. */
+#endif
+#ifndef ADV_SCHED_STEP_MS
+#define ADV_SCHED_STEP_MS               2000                                    /**< Time spent at each interval before doubling it. */
+#endif
+
+/**@brief Function for starting advertising with a burst, e.g. at power up. */
+void adv_sched_start(void);
+
+/**@brief Function for requesting a burst of fast advertising. */
+void adv_sched_kick(void);
+
+/**@brief Function for telling the scheduler whether a central is connected.
+ *
+ * @details Interval changes are suspended while connected. A disconnect starts a burst so the
+ *          peer can reconnect quickly.
+ */
+void adv_sched_conn_state_set(bool connected);
+
+/**@brief Function for getting the interval advertising currently runs at, 0 if stopped. */
+uint16_t adv_sched_interval_get(void);
+
+#endif // ADV_SCHED_H__
@@ -0,0 +1,120 @@
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nordic_common.h"
+#include "app_timer.h"
+#include "SEGGER_RTT.h"
+#include "bin_log.h"
+
+#define BIN_LOG_HDR_LEN             6
+#define BIN_LOG_MAX_ARGS            6
+#define BIN_LOG_ARG_MAX_LEN         MAX(sizeof(uint32_t), 1 + BIN_LOG_STR_MAX)
+
+static uint8_t           m_rtt_buf[BIN_LOG_RTT_BUFFER_SIZE];
+static volatile uint32_t m_dropped;
+
+static void hdr_encode(uint8_t * p_hdr, uint8_t level, uint8_t argc, uint16_t fmt_id)
+{
+    uint32_t ticks = app_timer_cnt_get();
+
+    p_hdr[0] = (uint8_t)(level << 4 | (argc & 0x0F));
+    p_hdr[1] = (uint8_t)fmt_id;
+    p_hdr[2] = (uint8_t)(fmt_id >> 8);
+    p_hdr[3] = (uint8_t)ticks;
+    p_hdr[4] = (uint8_t)(ticks >> 8);
+    p_hdr[5] = (uint8_t)(ticks >> 16);
+}
+
+static void record_write(const uint8_t * p_rec, uint32_t len)
+{
+    /* Skip mode drops the whole record when it does not fit, so the stream never desyncs. */
+    if (SEGGER_RTT_Write(BIN_LOG_RTT_CHANNEL, p_rec, len) == 0)
+        m_dropped++;
+}
+
+void bin_log_init(void)
+{
+    SEGGER_RTT_ConfigUpBuffer(BIN_LOG_RTT_CHANNEL, "bin_log", m_rtt_buf, sizeof(m_rtt_buf),
+                              SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+/* Returns the conversion character of the next argument in *pp_fmt and moves past it, '\0' if
+ * the format has no more arguments. */
+static char fmt_next_conv(const char ** pp_fmt)
+{
+    const char * p = *pp_fmt;
+
+    while ((p = strchr(p, '%')) != NULL) {
+        p++;
+        while (*p != '\0' && strchr("-+ #0123456789.hlzjt", *p) != NULL)
+            p++;
+        if (*p == '\0')
+            break;
+        if (*p++ != '%') {
+            *pp_fmt = p;
+            return p[-1];
+        }
+    }
+
+    return '\0';
+}
+
+void bin_log_write(uint8_t level, const char * p_fmt, uint8_t argc, ...)
+{
+    uint8_t      rec[BIN_LOG_HDR_LEN + BIN_LOG_MAX_ARGS * BIN_LOG_ARG_MAX_LEN];
+    uint8_t     *p_arg = rec + BIN_LOG_HDR_LEN;
+    uint16_t     fmt_id = (uint16_t)(p_fmt - (const char *)NRF_SECTION_START_ADDR(bin_log_fmt));
+    const char * p_conv = p_fmt;
+    va_list      args;
+
+    argc = MIN(argc, BIN_LOG_MAX_ARGS);
+    hdr_encode(rec, level, argc, fmt_id);
+
+    va_start(args, argc);
+    for (uint8_t i = 0; i < argc; i++) {
+        uint32_t val = va_arg(args, uint32_t);
+
+        if (fmt_next_conv(&p_conv) == 's') {
+            /* The string may live in RAM, e.g. a formatted time, the decoder cannot read it. */
+            const char * p_str = (const char *)(uintptr_t)val;
+            uint8_t      len   = 0;
+
+            while (p_str != NULL && len < BIN_LOG_STR_MAX && p_str[len] != '\0')
+                len++;
+            *p_arg++ = len;
+            if (len != 0)
+                memcpy(p_arg, p_str, len);
+            p_arg += len;
+        } else {
+            memcpy(p_arg, &val, sizeof(val));
+            p_arg += sizeof(val);
+        }
+    }
+    va_end(args);
+
+    record_write(rec, p_arg - rec);
+}
+
+void bin_log_hexdump(const void * p_data, uint32_t len)
+{
+    uint8_t         rec[BIN_LOG_HDR_LEN + 1 + BIN_LOG_HEXDUMP_CHUNK];
+    const uint8_t * p_src = p_data;
+
+    do {
+        uint8_t chunk = (uint8_t)MIN(len, BIN_LOG_HEXDUMP_CHUNK);
+
+        hdr_encode(rec, BIN_LOG_LEVEL_HEXDUMP, 0, 0);
+        rec[BIN_LOG_HDR_LEN] = chunk;
+        memcpy(rec + BIN_LOG_HDR_LEN + 1, p_src, chunk);
+        record_write(rec, BIN_LOG_HDR_LEN + 1 + chunk);
+
+        p_src += chunk;
+        len   -= chunk;
+    } while (len > 0);
+}
+
+uint32_t bin_log_dropped_get(void)
+{
+    return m_dropped;
+}
@@ -0,0 +1,107 @@
+/**@file
+ *
+ * @brief Binary (dictionary based) logging backend.
+ *
+ * @details Format strings are never rendered on the target. Each format string is placed in the
+ *          bin_log_fmt linker section and a log call only emits its offset in that section, the
+ *          log level, a 24-bit RTC timestamp and the raw 32-bit arguments to a dedicated RTT up
+ *          channel. tools/bin_log_decode.py rebuilds the text from the ELF file.
+ *
+ *          Record layout (little endian):
+ *          | level:4 argc:4 | fmt_id:16 | rtc_ticks:24 | argc * arg |
+ *          An argument is the raw 32-bit value, except for %s where the string itself is
+ *          carried as | len:8 | chars |, cut at BIN_LOG_STR_MAX, so strings built in RAM are
+ *          logged too. Hex dumps use level BIN_LOG_LEVEL_HEXDUMP, fmt_id 0 and carry
+ *          | len:8 | data | instead of arguments.
+ *
+ *          Records above BIN_LOG_LEVEL are not emitted, as the text backend does for
+ *          MI_LOG_LEVEL. Hex dumps count as debug output.
+ *
+ * @note Floating point arguments are not supported.
+ */
+#ifndef BIN_LOG_H__
+#define BIN_LOG_H__
+
+#include <stdint.h>
+#include "app_util.h"
+#include "nrf_section.h"
+
+#ifndef BIN_LOG_RTT_CHANNEL
+#define BIN_LOG_RTT_CHANNEL             1                                       /**< RTT up channel used for binary records. */
+#endif
+
+#ifndef BIN_LOG_RTT_BUFFER_SIZE
+#define BIN_LOG_RTT_BUFFER_SIZE         1024
+#endif
+
+#define BIN_LOG_HEXDUMP_CHUNK           64                                      /**< Longer dumps are split into several records. */
+#define BIN_LOG_STR_MAX                 32                                      /**< Longest %s argument carried, longer strings are cut. */
+
+#define BIN_LOG_LEVEL_ERROR             1
+#define BIN_LOG_LEVEL_WARNING           2
+#define BIN_LOG_LEVEL_INFO              3
+#define BIN_LOG_LEVEL_DEBUG             4
+#define BIN_LOG_LEVEL_HEXDUMP           15
+
+NRF_SECTION_DEF(bin_log_fmt, const char);
+
+#define BIN_LOG_ARGS_0(fmt)
+#define BIN_LOG_ARGS_1(fmt, a1)                         , (uint32_t)(a1)
+#define BIN_LOG_ARGS_2(fmt, a1, a2)                     , (uint32_t)(a1), (uint32_t)(a2)
+#define BIN_LOG_ARGS_3(fmt, a1, a2, a3)                 BIN_LOG_ARGS_2(fmt, a1, a2), (uint32_t)(a3)
+#define BIN_LOG_ARGS_4(fmt, a1, a2, a3, a4)             BIN_LOG_ARGS_3(fmt, a1, a2, a3), (uint32_t)(a4)
+#define BIN_LOG_ARGS_5(fmt, a1, a2, a3, a4, a5)         BIN_LOG_ARGS_4(fmt, a1, a2, a3, a4), (uint32_t)(a5)
+#define BIN_LOG_ARGS_6(fmt, a1, a2, a3, a4, a5, a6)     BIN_LOG_ARGS_5(fmt, a1, a2, a3, a4, a5), (uint32_t)(a6)
+
+/**@brief Macro for logging a message with up to 6 integer, pointer or string arguments. */
+#define BIN_LOG(level, ...)                                                                     \
+    do {                                                                                        \
+        if ((level) <= BIN_LOG_LEVEL) {                                                         \
+            NRF_SECTION_ITEM_REGISTER(bin_log_fmt, static const char _bin_log_fmt[]) =          \
+                GET_VA_ARG_1(__VA_ARGS__);                                                      \
+            bin_log_write(level, _bin_log_fmt, NUM_VA_ARGS_LESS_1(__VA_ARGS__)                  \
+                          CONCAT_2(BIN_LOG_ARGS_, NUM_VA_ARGS_LESS_1(__VA_ARGS__))(__VA_ARGS__)); \
+        }                                                                                       \
+    } while (0)
+
+#define BIN_LOG_HEXDUMP(p_data, len)                                                            \
+    do {                                                                                        \
+        if (BIN_LOG_LEVEL_DEBUG <= BIN_LOG_LEVEL)                                               \
+            bin_log_hexdump((p_data), (len));                                                   \
+    } while (0)
+
+/**@brief Function for configuring the binary log RTT channel. */
+void bin_log_init(void);
+
+void bin_log_write(uint8_t level, const char * p_fmt, uint8_t argc, ...);
+
+void bin_log_hexdump(const void * p_data, uint32_t len);
+
+/**@brief Function for getting the number of records dropped because the RTT buffer was full. */
+uint32_t bin_log_dropped_get(void);
+
+/* Route the MI_LOG macros of the including file to the binary backend. */
+#if defined(MI_LOG_BINARY) && (MI_LOG_BINARY == 1)
+#include "mible_log.h"
+#undef  MI_LOG_ERROR
+#undef  MI_LOG_WARNING
+#undef  MI_LOG_INFO
+#undef  MI_LOG_DEBUG
+#undef  MI_LOG_HEXDUMP
+#define MI_LOG_ERROR(...)               BIN_LOG(BIN_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define MI_LOG_WARNING(...)             BIN_LOG(BIN_LOG_LEVEL_WARNING, __VA_ARGS__)
+#define MI_LOG_INFO(...)                BIN_LOG(BIN_LOG_LEVEL_INFO, __VA_ARGS__)
+#define MI_LOG_DEBUG(...)               BIN_LOG(BIN_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define MI_LOG_HEXDUMP(p_data, len)     BIN_LOG_HEXDUMP(p_data, len)
+#endif
+
+/* Same threshold as the text backend. */
+#ifndef BIN_LOG_LEVEL
+#if defined(MI_LOG_LEVEL)
+#define BIN_LOG_LEVEL                   MI_LOG_LEVEL
+#else
+#define BIN_LOG_LEVEL                   BIN_LOG_LEVEL_INFO
+#endif
+#endif
+
+#endif // BIN_LOG_H__
@@ -63,5 +63,21 @@
 #define TIME_PROFILE           0
 #endif
 
+/**
+ * @note Application MI_LOG output as binary records on RTT channel 1 instead of text.
+ * Decode on the host with tools/bin_log_decode.py and the matching .axf file.
+ */
+#ifndef MI_LOG_BINARY
+#define MI_LOG_BINARY          0
+#endif
+
+/**
+ * @note Diagnostic commands over the stdio service, e.g. "mem". Their reports contain code
+ * addresses and are readable by any logged in user, enable for debug builds only.
+ */
+#ifndef STDIO_DEBUG_CMDS
+#define STDIO_DEBUG_CMDS       0
+#endif
+
 
 #endif
@@ -0,0 +1,157 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nordic_common.h"
+#include "nrf.h"
+#include "nrf_soc.h"
+#include "nrf_nvic.h"
+#include "nrf_sdh_ble.h"
+#include "nrf_sdh_soc.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "energy_stats.h"
+
+#define RADIO_NOTIFICATION_IRQn         SWI1_EGU1_IRQn
+#define RADIO_NOTIFICATION_IRQHandler   SWI1_EGU1_IRQHandler
+#define RADIO_NOTIFICATION_DISTANCE     NRF_RADIO_NOTIFICATION_DISTANCE_800US
+#define RADIO_NOTIFICATION_DISTANCE_US  800
+
+#define ENERGY_BLE_OBSERVER_PRIO        0                                       /* Ahead of the application, ends WFE first. */
+#define ENERGY_SOC_OBSERVER_PRIO        0
+
+#define US_TO_TICKS(us)                 ((us) * APP_TIMER_CLOCK_FREQ / 1000000)
+
+static const uint16_t m_current_ua[ENERGY_STATE_COUNT] = {
+    [ENERGY_STATE_CPU]   = ENERGY_CURRENT_CPU_UA,
+    [ENERGY_STATE_WFE]   = ENERGY_CURRENT_WFE_UA,
+    [ENERGY_STATE_RADIO] = ENERGY_CURRENT_RADIO_UA,
+    [ENERGY_STATE_MSC]   = ENERGY_CURRENT_MSC_UA,
+    [ENERGY_STATE_FLASH] = ENERGY_CURRENT_FLASH_UA,
+};
+
+static const char * const m_names[ENERGY_STATE_COUNT] = {
+    "cpu", "wfe", "radio", "msc", "flash",
+};
+
+static uint64_t m_ticks[ENERGY_STATE_COUNT];
+static uint64_t m_uptime;
+static uint32_t m_last_cnt;
+static uint32_t m_active;                       /* Bit mask of active states. */
+
+static volatile bool     m_radio_active;
+static volatile uint32_t m_radio_events;
+static volatile uint32_t m_flash_ops;
+
+/* Adds the time since the last transition to every active state. Caller holds the critical region. */
+static void fold(void)
+{
+    uint32_t now  = app_timer_cnt_get();
+    uint32_t diff = app_timer_cnt_diff_compute(now, m_last_cnt);
+
+    m_last_cnt = now;
+    m_uptime  += diff;
+    for (int i = 0; i < ENERGY_STATE_COUNT; i++) {
+        if (m_active & (1UL << i))
+            m_ticks[i] += diff;
+    }
+}
+
+void energy_state_set(energy_state_t state, bool active)
+{
+    if (state >= ENERGY_STATE_COUNT || state == ENERGY_STATE_CPU)
+        return;
+
+    CRITICAL_REGION_ENTER();
+    fold();
+    if (active)
+        m_active |= 1UL << state;
+    else
+        m_active &= ~(1UL << state);
+    CRITICAL_REGION_EXIT();
+}
+
+/* Ends WFE at the first interrupt after wakeup. Without it, SoftDevice events handled in
+ * interrupt context before nrf_pwr_mgmt_run() returns would be accounted as sleep. */
+static void wakeup(void)
+{
+    CRITICAL_REGION_ENTER();
+    if (m_active & (1UL << ENERGY_STATE_WFE)) {
+        fold();
+        m_active &= ~(1UL << ENERGY_STATE_WFE);
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+/* Radio notifications alternate between ACTIVE, ahead of a radio event, and INACTIVE after it. */
+void RADIO_NOTIFICATION_IRQHandler(void)
+{
+    wakeup();
+    m_radio_active = !m_radio_active;
+    if (m_radio_active)
+        m_radio_events++;
+    energy_state_set(ENERGY_STATE_RADIO, m_radio_active);
+}
+
+static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
+{
+    wakeup();
+}
+
+NRF_SDH_BLE_OBSERVER(m_energy_ble_observer, ENERGY_BLE_OBSERVER_PRIO, ble_evt_handler, NULL);
+
+static void soc_evt_handler(uint32_t evt_id, void * p_context)
+{
+    wakeup();
+    if (evt_id == NRF_EVT_FLASH_OPERATION_SUCCESS || evt_id == NRF_EVT_FLASH_OPERATION_ERROR)
+        m_flash_ops++;
+}
+
+NRF_SDH_SOC_OBSERVER(m_energy_soc_observer, ENERGY_SOC_OBSERVER_PRIO, soc_evt_handler, NULL);
+
+ret_code_t energy_stats_init(void)
+{
+    ret_code_t err_code;
+
+    m_last_cnt = app_timer_cnt_get();
+
+    err_code = sd_nvic_ClearPendingIRQ(RADIO_NOTIFICATION_IRQn);
+    VERIFY_SUCCESS(err_code);
+    err_code = sd_nvic_SetPriority(RADIO_NOTIFICATION_IRQn, APP_IRQ_PRIORITY_LOW);
+    VERIFY_SUCCESS(err_code);
+    err_code = sd_nvic_EnableIRQ(RADIO_NOTIFICATION_IRQn);
+    VERIFY_SUCCESS(err_code);
+
+    return sd_radio_notification_cfg_set(NRF_RADIO_NOTIFICATION_TYPE_INT_ON_BOTH,
+                                         RADIO_NOTIFICATION_DISTANCE);
+}
+
+void energy_stats_get(energy_stats_t * p_stats)
+{
+    uint64_t ticks[ENERGY_STATE_COUNT];
+    uint64_t uptime;
+
+    CRITICAL_REGION_ENTER();
+    fold();
+    memcpy(ticks, m_ticks, sizeof(ticks));
+    uptime = m_uptime;
+    CRITICAL_REGION_EXIT();
+
+    /* The ACTIVE notification comes ahead of the radio event, that lead time is not radio time. */
+    uint64_t lead = US_TO_TICKS((uint64_t)m_radio_events * RADIO_NOTIFICATION_DISTANCE_US);
+    ticks[ENERGY_STATE_RADIO] -= MIN(lead, ticks[ENERGY_STATE_RADIO]);
+    ticks[ENERGY_STATE_FLASH] += US_TO_TICKS((uint64_t)m_flash_ops * ENERGY_FLASH_OP_US);
+    ticks[ENERGY_STATE_CPU]    = uptime - ticks[ENERGY_STATE_WFE];
+
+    p_stats->uptime_s = uptime / APP_TIMER_CLOCK_FREQ;
+    for (int i = 0; i < ENERGY_STATE_COUNT; i++) {
+        p_stats->time_s[i]     = ticks[i] / APP_TIMER_CLOCK_FREQ;
+        /* uA * s / 3.6 = nAh */
+        p_stats->charge_nah[i] = ticks[i] * m_current_ua[i] * 10 / (36ULL * APP_TIMER_CLOCK_FREQ);
+    }
+}
+
+const char * energy_state_name(energy_state_t state)
+{
+    return state < ENERGY_STATE_COUNT ? m_names[state] : "?";
+}
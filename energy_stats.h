@@ -0,0 +1,87 @@
+/**@file
+ *
+ * @brief Time and charge accounting per power consuming subsystem.
+ *
+ * @details The application marks the start and end of each state with energy_state_set(). All
+ *          states are folded into their accumulators on every transition, so intervals never
+ *          exceed the time between two main loop wakeups and the 24-bit RTC cannot wrap
+ *          unnoticed. The CPU is either running or sleeping in WFE; the radio, the secure chip
+ *          and the flash add their own current on top of that. WFE also ends at the first
+ *          SoftDevice event or radio notification after wakeup, as those interrupts run before
+ *          the main loop resumes. Other short interrupts, e.g. app_timer, still count as WFE.
+ *
+ *          The charge estimate multiplies the accumulated time with the typical current of each
+ *          state. The defaults are datasheet values at 3 V with the internal LDO; measure the
+ *          board and override the ENERGY_CURRENT_*_UA defines for battery sizing.
+ */
+#ifndef ENERGY_STATS_H__
+#define ENERGY_STATS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdk_errors.h"
+
+#if defined(NRF52840_XXAA)
+#define ENERGY_CURRENT_CPU_DEFAULT_UA   3300
+#define ENERGY_CURRENT_WFE_DEFAULT_UA   3
+#define ENERGY_CURRENT_RADIO_DEFAULT_UA 9600                                    /**< Average of TX 0 dBm and RX 1 Mbps. */
+#elif defined(NRF52810_XXAA)
+#define ENERGY_CURRENT_CPU_DEFAULT_UA   2800
+#define ENERGY_CURRENT_WFE_DEFAULT_UA   2
+#define ENERGY_CURRENT_RADIO_DEFAULT_UA 6700
+#else
+#define ENERGY_CURRENT_CPU_DEFAULT_UA   3700
+#define ENERGY_CURRENT_WFE_DEFAULT_UA   2
+#define ENERGY_CURRENT_RADIO_DEFAULT_UA 6900
+#endif
+
+#ifndef ENERGY_CURRENT_CPU_UA
+#define ENERGY_CURRENT_CPU_UA           ENERGY_CURRENT_CPU_DEFAULT_UA           /**< CPU running from flash, cache enabled. */
+#endif
+#ifndef ENERGY_CURRENT_WFE_UA
+#define ENERGY_CURRENT_WFE_UA           ENERGY_CURRENT_WFE_DEFAULT_UA           /**< System ON idle, RTC running, full RAM retention. */
+#endif
+#ifndef ENERGY_CURRENT_RADIO_UA
+#define ENERGY_CURRENT_RADIO_UA         ENERGY_CURRENT_RADIO_DEFAULT_UA
+#endif
+#ifndef ENERGY_CURRENT_MSC_UA
+#define ENERGY_CURRENT_MSC_UA           1500                                    /**< Mijia secure chip while powered. */
+#endif
+#ifndef ENERGY_CURRENT_FLASH_UA
+#define ENERGY_CURRENT_FLASH_UA         7500                                    /**< NVMC page erase. */
+#endif
+#ifndef ENERGY_FLASH_OP_US
+#define ENERGY_FLASH_OP_US              2100                                    /**< Assumed duration of one SoftDevice flash operation. */
+#endif
+
+typedef enum {
+    ENERGY_STATE_CPU,                   /**< Derived: everything not spent in WFE. */
+    ENERGY_STATE_WFE,
+    ENERGY_STATE_RADIO,                 /**< Radio TX and RX, the SoftDevice does not tell them apart. */
+    ENERGY_STATE_MSC,
+    ENERGY_STATE_FLASH,                 /**< Estimated from completed SoftDevice flash operations. */
+    ENERGY_STATE_COUNT,
+} energy_state_t;
+
+typedef struct {
+    uint32_t time_s[ENERGY_STATE_COUNT];
+    uint32_t charge_nah[ENERGY_STATE_COUNT];    /**< Estimated charge in nAh, wraps at 4.2 Ah. */
+    uint32_t uptime_s;
+} energy_stats_t;
+
+/**@brief Function for initializing the accounting and the radio notifications.
+ *
+ * @note The SoftDevice must be enabled before.
+ */
+ret_code_t energy_stats_init(void);
+
+/**@brief Function for entering or leaving a state. Safe to call from interrupt context. */
+void energy_state_set(energy_state_t state, bool active);
+
+/**@brief Function for reading the accumulated times and charge estimates. */
+void energy_stats_get(energy_stats_t * p_stats);
+
+/**@brief Function for getting the short name of a state, e.g. for reports. */
+const char * energy_state_name(energy_state_t state);
+
+#endif // ENERGY_STATS_H__
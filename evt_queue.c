@@ -0,0 +1,233 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nordic_common.h"
+#include "app_error.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "evt_queue.h"
+
+#define RTC_COUNTER_MASK            0x00FFFFFF
+#define RTC_HALF_RANGE              0x00800000
+#define RTC_TICKS_PER_HOUR          (3600ULL * APP_TIMER_CLOCK_FREQ)
+
+typedef struct {
+    evt_handler_t handler;
+    void *        p_context;
+    uint32_t      deadline;
+    uint32_t      slack;
+    uint32_t      period;
+    uint8_t       prio;
+} evt_t;
+
+APP_TIMER_DEF(m_wakeup_timer);
+
+static evt_t         m_evts[EVT_QUEUE_SIZE];
+static volatile bool m_timer_armed;
+static uint32_t      m_armed_deadline;
+
+static volatile uint32_t m_timer_wakeups;
+static uint32_t          m_dispatched;
+static uint32_t          m_last_cnt;
+static uint64_t          m_elapsed_ticks;
+
+static void wakeup_timer_handler(void * p_context)
+{
+    /* Returning from the interrupt wakes up the main loop, which dispatches the due events. */
+    m_timer_armed = false;
+    m_timer_wakeups++;
+}
+
+static uint32_t ticks_until(uint32_t deadline, uint32_t now)
+{
+    uint32_t diff = app_timer_cnt_diff_compute(deadline, now);
+    /* Deadlines behind the current counter value are already due. */
+    return diff >= RTC_HALF_RANGE ? 0 : diff;
+}
+
+static evt_t * evt_find(evt_handler_t handler, void * p_context)
+{
+    for (int i = 0; i < EVT_QUEUE_SIZE; i++) {
+        if (m_evts[i].handler == handler && m_evts[i].p_context == p_context)
+            return &m_evts[i];
+    }
+    return NULL;
+}
+
+static ret_code_t evt_insert(evt_t const * p_new)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+
+    CRITICAL_REGION_ENTER();
+    evt_t * p_evt = evt_find(p_new->handler, p_new->p_context);
+    if (p_evt == NULL)
+        p_evt = evt_find(NULL, NULL);
+
+    if (p_evt == NULL)
+        err_code = NRF_ERROR_NO_MEM;
+    else
+        *p_evt = *p_new;
+    CRITICAL_REGION_EXIT();
+
+    return err_code;
+}
+
+static ret_code_t evt_schedule(evt_handler_t handler, void * p_context, evt_prio_t prio,
+                               uint32_t delay_ms, uint32_t slack_ms, bool periodic)
+{
+    if (handler == NULL)
+        return NRF_ERROR_NULL;
+
+    if (delay_ms + slack_ms > EVT_QUEUE_MAX_DELAY_MS || (periodic && delay_ms == 0))
+        return NRF_ERROR_INVALID_PARAM;
+
+    evt_t evt = {
+        .handler   = handler,
+        .p_context = p_context,
+        .deadline  = (app_timer_cnt_get() + APP_TIMER_TICKS(delay_ms)) & RTC_COUNTER_MASK,
+        .slack     = APP_TIMER_TICKS(slack_ms),
+        .period    = periodic ? APP_TIMER_TICKS(delay_ms) : 0,
+        .prio      = prio,
+    };
+
+    return evt_insert(&evt);
+}
+
+ret_code_t evt_queue_init(void)
+{
+    memset(m_evts, 0, sizeof(m_evts));
+    m_timer_armed   = false;
+    m_timer_wakeups = 0;
+    m_dispatched    = 0;
+    m_elapsed_ticks = 0;
+    m_last_cnt      = app_timer_cnt_get();
+    return app_timer_create(&m_wakeup_timer, APP_TIMER_MODE_SINGLE_SHOT, wakeup_timer_handler);
+}
+
+ret_code_t evt_post(evt_handler_t handler, void * p_context, evt_prio_t prio)
+{
+    return evt_schedule(handler, p_context, prio, 0, 0, false);
+}
+
+ret_code_t evt_post_delayed(evt_handler_t handler, void * p_context, evt_prio_t prio,
+                            uint32_t delay_ms, uint32_t slack_ms)
+{
+    return evt_schedule(handler, p_context, prio, delay_ms, slack_ms, false);
+}
+
+ret_code_t evt_post_periodic(evt_handler_t handler, void * p_context, evt_prio_t prio,
+                             uint32_t period_ms, uint32_t slack_ms)
+{
+    return evt_schedule(handler, p_context, prio, period_ms, slack_ms, true);
+}
+
+void evt_cancel(evt_handler_t handler, void * p_context)
+{
+    CRITICAL_REGION_ENTER();
+    evt_t * p_evt = evt_find(handler, p_context);
+    if (p_evt != NULL)
+        memset(p_evt, 0, sizeof(evt_t));
+    CRITICAL_REGION_EXIT();
+}
+
+/* Pops the highest priority due event, earliest deadline first within the same priority.
+ * Periodic events stay queued with their next deadline. */
+static bool evt_pop_due(uint32_t now, evt_t * p_out)
+{
+    evt_t * p_best = NULL;
+
+    CRITICAL_REGION_ENTER();
+    for (int i = 0; i < EVT_QUEUE_SIZE; i++) {
+        evt_t * p_evt = &m_evts[i];
+        if (p_evt->handler == NULL || ticks_until(p_evt->deadline, now) != 0)
+            continue;
+
+        if (p_best == NULL || p_evt->prio < p_best->prio ||
+            (p_evt->prio == p_best->prio &&
+             app_timer_cnt_diff_compute(p_best->deadline, p_evt->deadline) < RTC_HALF_RANGE))
+            p_best = p_evt;
+    }
+
+    if (p_best != NULL) {
+        *p_out = *p_best;
+        if (p_best->period == 0) {
+            memset(p_best, 0, sizeof(evt_t));
+        } else {
+            p_best->deadline = (p_best->deadline + p_best->period) & RTC_COUNTER_MASK;
+            /* Missed more than a whole period: restart the cadence from now. */
+            if (ticks_until(p_best->deadline, now) == 0)
+                p_best->deadline = (now + p_best->period) & RTC_COUNTER_MASK;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    return p_best != NULL;
+}
+
+static void wakeup_timer_rearm(uint32_t now)
+{
+    bool     pending   = false;
+    uint32_t next      = 0;
+    uint32_t min_ticks = UINT32_MAX;
+
+    CRITICAL_REGION_ENTER();
+    for (int i = 0; i < EVT_QUEUE_SIZE; i++) {
+        if (m_evts[i].handler == NULL)
+            continue;
+
+        /* Wake up at the end of the slack window, anything due by then runs in the same pass. */
+        uint32_t latest = (m_evts[i].deadline + m_evts[i].slack) & RTC_COUNTER_MASK;
+        uint32_t ticks  = ticks_until(latest, now);
+        if (ticks < min_ticks) {
+            min_ticks = ticks;
+            next      = latest;
+            pending   = true;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (!pending) {
+        if (m_timer_armed) {
+            app_timer_stop(m_wakeup_timer);
+            m_timer_armed = false;
+        }
+        return;
+    }
+
+    if (m_timer_armed && m_armed_deadline == next)
+        return;
+
+    if (m_timer_armed)
+        app_timer_stop(m_wakeup_timer);
+
+    m_armed_deadline = next;
+    m_timer_armed    = true;
+    ret_code_t err_code = app_timer_start(m_wakeup_timer, MAX(min_ticks, APP_TIMER_MIN_TIMEOUT_TICKS), NULL);
+    APP_ERROR_CHECK(err_code);
+}
+
+void evt_queue_process(void)
+{
+    evt_t    evt;
+    uint32_t now = app_timer_cnt_get();
+
+    /* Uptime is accumulated here, the periodic events keep passes well within the counter period. */
+    m_elapsed_ticks += app_timer_cnt_diff_compute(now, m_last_cnt);
+    m_last_cnt       = now;
+
+    while (evt_pop_due(app_timer_cnt_get(), &evt)) {
+        evt.handler(evt.p_context);
+        m_dispatched++;
+    }
+
+    wakeup_timer_rearm(app_timer_cnt_get());
+}
+
+void evt_queue_stats_get(evt_queue_stats_t * p_stats)
+{
+    p_stats->timer_wakeups          = m_timer_wakeups;
+    p_stats->dispatched             = m_dispatched;
+    p_stats->timer_wakeups_per_hour = m_elapsed_ticks == 0 ? 0 :
+                                      (uint32_t)(m_timer_wakeups * RTC_TICKS_PER_HOUR / m_elapsed_ticks);
+}
@@ -0,0 +1,87 @@
+/**@file
+ *
+ * @brief Priority ordered application event queue with explicit wakeup deadlines.
+ *
+ * @details Work is posted as (handler, context) pairs, either for immediate execution or with a
+ *          deadline. Pending work is dispatched from the main loop by evt_queue_process(), highest
+ *          priority first and earliest deadline first within a priority. A single one-shot
+ *          app_timer is armed for the earliest pending deadline only, so the CPU is not woken
+ *          up while nothing is due.
+ *
+ *          Delayed and periodic events carry a slack window: the event may run anywhere between
+ *          its deadline and deadline + slack. The wakeup timer is armed for the latest point that
+ *          still honours every pending window, so timers that fall close together share one RTC
+ *          compare, and events that become due while the CPU is awake anyway run without a
+ *          dedicated wakeup.
+ */
+#ifndef EVT_QUEUE_H__
+#define EVT_QUEUE_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+#ifndef EVT_QUEUE_SIZE
+#define EVT_QUEUE_SIZE                  12                                      /**< Maximum number of pending events. A handler and context pair takes one slot at most, size for the distinct pairs plus margin. */
+#endif
+
+#define EVT_QUEUE_MAX_DELAY_MS          250000                                  /**< Longest delay plus slack representable by the 24-bit RTC counter. */
+
+typedef void (*evt_handler_t)(void * p_context);
+
+typedef enum {
+    EVT_PRIO_HIGH = 0,
+    EVT_PRIO_NORMAL,
+    EVT_PRIO_LOW,
+} evt_prio_t;
+
+typedef struct {
+    uint32_t timer_wakeups;             /**< Number of times the queue's own wakeup timer fired. */
+    uint32_t dispatched;                /**< Number of events handled. */
+    uint32_t timer_wakeups_per_hour;    /**< Rate of the above averaged since evt_queue_init(). Not the
+                                             device wakeup rate: wakeups by the SoftDevice, the radio or
+                                             other timers are not counted. */
+} evt_queue_stats_t;
+
+/**@brief Function for initializing the event queue.
+ *
+ * @note app_timer_init() must be called before.
+ */
+ret_code_t evt_queue_init(void);
+
+/**@brief Function for posting an event to be handled on the next main loop pass.
+ *
+ * @details Safe to call from interrupt context.
+ */
+ret_code_t evt_post(evt_handler_t handler, void * p_context, evt_prio_t prio);
+
+/**@brief Function for posting an event to be handled once @p delay_ms has elapsed.
+ *
+ * @details An already pending event with the same handler and context is rescheduled instead of
+ *          being queued twice. Safe to call from interrupt context.
+ *
+ * @param[in] slack_ms  How late the event may run so that its wakeup can be merged with others.
+ */
+ret_code_t evt_post_delayed(evt_handler_t handler, void * p_context, evt_prio_t prio,
+                            uint32_t delay_ms, uint32_t slack_ms);
+
+/**@brief Function for posting an event to be handled every @p period_ms until cancelled.
+ *
+ * @details The period is kept relative to the original deadline, so a late run caused by the
+ *          slack window does not make the event drift.
+ */
+ret_code_t evt_post_periodic(evt_handler_t handler, void * p_context, evt_prio_t prio,
+                             uint32_t period_ms, uint32_t slack_ms);
+
+/**@brief Function for removing a pending event. */
+void evt_cancel(evt_handler_t handler, void * p_context);
+
+/**@brief Function for dispatching all due events and arming the wakeup timer for the next one.
+ *
+ * @details Must be called from the main loop only.
+ */
+void evt_queue_process(void);
+
+/**@brief Function for reading the statistics of the queue's wakeup timer. */
+void evt_queue_stats_get(evt_queue_stats_t * p_stats);
+
+#endif // EVT_QUEUE_H__
@@ -0,0 +1,66 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "nordic_common.h"
+#include "nrf.h"
+#include "nrf_atomic.h"
+#include "app_timer.h"
+#include "gatt_trace.h"
+
+#if (GATT_TRACE_ENABLED == 1)
+
+STATIC_ASSERT((GATT_TRACE_SIZE & (GATT_TRACE_SIZE - 1)) == 0);
+
+#define GATT_TRACE_MASK             (GATT_TRACE_SIZE - 1)
+
+static gatt_trace_rec_t  m_ring[GATT_TRACE_SIZE];
+static nrf_atomic_u32_t  m_head;
+
+void gatt_trace_record(gatt_trace_type_t type, uint16_t handle, const void * p_data, uint16_t len)
+{
+    uint32_t           idx   = nrf_atomic_u32_fetch_add(&m_head, 1);
+    gatt_trace_rec_t * p_rec = &m_ring[idx & GATT_TRACE_MASK];
+
+    /* Invalidate the slot first so a concurrent dump never sees a half written record. */
+    p_rec->seq = 0;
+    __DMB();
+
+    p_rec->ticks  = app_timer_cnt_get();
+    p_rec->type   = type;
+    p_rec->len    = MIN(len, UINT8_MAX);
+    p_rec->handle = handle;
+    memset(p_rec->data, 0, GATT_TRACE_DATA_LEN);
+    if (p_data != NULL)
+        memcpy(p_rec->data, p_data, MIN(len, GATT_TRACE_DATA_LEN));
+
+    __DMB();
+    p_rec->seq = idx + 1;
+}
+
+uint32_t gatt_trace_dump(gatt_trace_out_t out)
+{
+    uint32_t         head  = m_head;
+    uint32_t         first = head > GATT_TRACE_SIZE ? head - GATT_TRACE_SIZE : 0;
+    uint32_t         cnt   = 0;
+    gatt_trace_rec_t rec;
+
+    for (uint32_t idx = first; idx != head; idx++) {
+        gatt_trace_rec_t const * p_rec = &m_ring[idx & GATT_TRACE_MASK];
+
+        if (p_rec->seq != idx + 1)
+            continue;
+        rec = *p_rec;
+        __DMB();
+        /* Overwritten while copying. */
+        if (p_rec->seq != idx + 1)
+            continue;
+
+        if (out((const uint8_t *)&rec, sizeof(rec)) != 0)
+            break;
+        cnt++;
+    }
+
+    return cnt;
+}
+
+#endif // GATT_TRACE_ENABLED
@@ -0,0 +1,86 @@
+/**@file
+ *
+ * @brief Binary trace of GATT traffic, connection events and auth state in a RAM ring.
+ *
+ * @details Records have a fixed size and are written without locks: a writer reserves a slot
+ *          with an atomic increment of the head index and publishes the record by writing its
+ *          sequence number last. Recording is therefore safe from any interrupt priority and
+ *          never blocks. The oldest records are overwritten when the ring is full.
+ *
+ *          gatt_trace_dump() streams the records oldest first through a caller supplied
+ *          output function, e.g. RTT. tools/gatt_trace2pcap.py converts
+ *          such a dump into a pcap file that Wireshark decodes as HCI/ATT traffic.
+ *
+ *          The ring is a debug aid and costs GATT_TRACE_SIZE * 24 bytes of RAM plus the RTT
+ *          buffer of the application. It is off by default on the nRF52810. With
+ *          GATT_TRACE_ENABLED 0 the functions compile to nothing.
+ */
+#ifndef GATT_TRACE_H__
+#define GATT_TRACE_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+#ifndef GATT_TRACE_ENABLED
+#if defined(NRF52810_XXAA)
+#define GATT_TRACE_ENABLED              0
+#else
+#define GATT_TRACE_ENABLED              1
+#endif
+#endif
+
+#ifndef GATT_TRACE_SIZE
+#define GATT_TRACE_SIZE                 32                                      /**< Number of records, must be a power of two. */
+#endif
+
+#define GATT_TRACE_DATA_LEN             12                                      /**< Payload bytes kept per record. */
+
+typedef enum {
+    GATT_TRACE_CONNECT = 1,             /**< handle: conn handle, data: peer address type + address. */
+    GATT_TRACE_DISCONNECT,              /**< handle: conn handle, data: HCI reason. */
+    GATT_TRACE_WRITE,                   /**< handle: attribute handle, data: written value. */
+    GATT_TRACE_NOTIFY,                  /**< handle: conn handle, data: number of notifications completed. */
+    GATT_TRACE_AUTH,                    /**< handle: scheduler event id. */
+    GATT_TRACE_STDIO_RX,                /**< handle: 0, len: stdio frame length. The decrypted data is never kept. */
+} gatt_trace_type_t;
+
+typedef struct {
+    uint32_t seq;                       /**< Slot index + 1, written last to publish the record. */
+    uint32_t ticks;                     /**< RTC1 counter value. */
+    uint8_t  type;
+    uint8_t  len;                       /**< Original payload length saturated at 255, may exceed GATT_TRACE_DATA_LEN. */
+    uint16_t handle;
+    uint8_t  data[GATT_TRACE_DATA_LEN];
+} gatt_trace_rec_t;
+
+/**@brief Output function used by gatt_trace_dump(). Returns 0 on success. */
+typedef int (*gatt_trace_out_t)(const uint8_t * p_data, uint8_t len);
+
+#if (GATT_TRACE_ENABLED == 1)
+
+/**@brief Function for recording one event. Safe to call from interrupt context. */
+void gatt_trace_record(gatt_trace_type_t type, uint16_t handle, const void * p_data, uint16_t len);
+
+/**@brief Function for writing all complete records, oldest first.
+ *
+ * @details Records being overwritten while the dump runs are skipped.
+ *
+ * @return Number of records written.
+ */
+uint32_t gatt_trace_dump(gatt_trace_out_t out);
+
+#else
+
+static inline void gatt_trace_record(gatt_trace_type_t type, uint16_t handle, const void * p_data,
+                                     uint16_t len)
+{
+}
+
+static inline uint32_t gatt_trace_dump(gatt_trace_out_t out)
+{
+    return 0;
+}
+
+#endif // GATT_TRACE_ENABLED
+
+#endif // GATT_TRACE_H__
@@ -54,6 +54,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
+#include <stdarg.h>
 
 #include "nordic_common.h"
 #include "nrf.h"
@@ -82,6 +83,7 @@
 #include "nrf_log_default_backends.h"
 
 #include <time.h>
+#include "rtc_time.h"
 #include "SEGGER_RTT.h"
 #include "mible_log.h"
 #include "nRF5_evt.h"
@@ -91,6 +93,15 @@
 #include "mijia_profiles/lock_service_server.h"
 #include "mijia_profiles/stdio_service_server.h"
 #include "mi_config.h"
+#include "evt_queue.h"
+#include "bin_log.h"
+#include "gatt_trace.h"
+#include "energy_stats.h"
+#include "adv_sched.h"
+#include "spsc_ring.h"
+#include "mem_stats.h"
+#include "mem_pool.h"
+#include "session_arena.h"
 
 #define DEVICE_NAME                     "secure_demo"                           /**< Name of device. Will be included in the advertising data. */
 #define MANUFACTURER_NAME               "Xiaomi Inc."                           /**< Manufacturer. Will be passed to Device Information Service. */
@@ -109,13 +120,40 @@
 
 #define DEAD_BEEF                       0xDEADBEEF                              /**< Value used as error code on stack dump, can be used to identify stack location on stack unwind. */
 
+#define POLL_INTERVAL_MS                60000                                   /**< Battery and time report interval. */
+#define POLL_SLACK_MS                   5000                                    /**< Poll may run this late to share a wakeup with other events. */
+#define BIND_CONFIRM_TIMEOUT_MS         5000                                    /**< Time the bind confirm bit stays set in the mibeacon. */
+#define BIND_CONFIRM_SLACK_MS           500                                     /**< Allowed lateness of the bind confirm bit clear. */
+
+#define GATT_TRACE_RTT_CHANNEL          2                                       /**< RTT up channel the GATT trace is dumped to. */
+#define GATT_TRACE_RTT_BUFFER_SIZE      1024                                    /**< Holds a dump of the full ring, see the STATIC_ASSERT below. */
+#define ENERGY_STDIO_CMD                "energy"                                /**< stdio frame requesting the energy report. */
+#define MEM_STDIO_CMD                   "mem"                                   /**< stdio frame requesting the memory usage report, with STDIO_DEBUG_CMDS only. */
+#define MEM_PHASE_IDLE                  0xFFFF                                  /**< Memory usage phase while no auth step is running. */
+#define STDIO_RX_RING_SIZE              512                                     /**< Holds at least one maximum length frame. */
+#define STDIO_REPORT_RETRY_MS           50                                      /**< Delay before a report line the stdio transport refused is sent again. */
+#define STDIO_REPORT_RETRY_SLACK_MS     20
+#define STDIO_REPORT_RETRIES            20                                      /**< Failed sends of one line before the report is given up. */
+#define APP_EVT_HANDLERS                10                                      /**< Distinct handlers posted to the event queue, incl. adv_sched. */
+#define APP_EVT_MARGIN                  2                                       /**< Spare event queue slots, e.g. for library callbacks posted later. */
+
 
 NRF_BLE_GATT_DEF(m_gatt);                                                       /**< GATT module instance. */
 NRF_BLE_QWR_DEF(m_qwr);                                                         /**< Context for the Queued Write module.*/
-APP_TIMER_DEF(m_poll_timer);
-APP_TIMER_DEF(m_bindconfirm_timer);
 
 static uint16_t m_conn_handle = BLE_CONN_HANDLE_INVALID;                        /**< Handle of the current connection. */
+#if (GATT_TRACE_ENABLED == 1)
+static uint8_t  m_trace_rtt_buf[GATT_TRACE_RTT_BUFFER_SIZE];                    /**< RTT buffer of the GATT trace channel. */
+
+/* The channel skips writes that do not fit and the dump goes oldest first, so a smaller buffer
+ * would lose the newest records. RTT keeps one byte of the buffer unused. */
+STATIC_ASSERT(GATT_TRACE_RTT_BUFFER_SIZE > GATT_TRACE_SIZE * sizeof(gatt_trace_rec_t));
+#endif
+
+SPSC_RING_DEF(m_stdio_rx_ring, STDIO_RX_RING_SIZE);                             /**< stdio frames from the SoftDevice event handler to the main loop. */
+
+/* Posting a pending handler reschedules it, so the queue never holds more than one slot per handler. */
+STATIC_ASSERT(EVT_QUEUE_SIZE >= APP_EVT_HANDLERS + APP_EVT_MARGIN);
 
 /* YOUR_JOB: Declare all services structure your application is using
  *  BLE_XYZ_DEF(m_xyz);
@@ -126,6 +164,14 @@ static void advertising_init(bool solicited);
 static void advertising_start(void);
 static void poll_timer_handler(void * p_context);
 static void bind_confirm_timeout(void * p_context);
+#if (GATT_TRACE_ENABLED == 1)
+static void gatt_trace_rtt_dump(void * p_context);
+#endif
+static void kbd_scan_stop(void);
+#if (SESSION_ARENA_ENABLED == 1)
+static void auth_arena_end(void);
+static void auth_arena_reset(void * p_context);
+#endif
 void ble_lock_ops_handler(uint8_t opcode);
 /**@brief Callback function for asserts in the SoftDevice.
  *
@@ -163,11 +209,9 @@ static void timers_init(void)
        ret_code_t err_code;
        err_code = app_timer_create(&m_app_timer_id, APP_TIMER_MODE_REPEATED, timer_timeout_handler);
        APP_ERROR_CHECK(err_code); */
-    err_code = app_timer_create(&m_poll_timer, APP_TIMER_MODE_REPEATED, poll_timer_handler);
-    MI_ERR_CHECK(err_code);
-
-    err_code = app_timer_create(&m_bindconfirm_timer, APP_TIMER_MODE_SINGLE_SHOT, bind_confirm_timeout);
-    MI_ERR_CHECK(err_code);
+    // Poll and bind confirm timers are events of the queue, sharing one wakeup timer.
+    err_code = evt_queue_init();
+    APP_ERROR_CHECK(err_code);
 }
 
 
@@ -354,7 +398,7 @@ static void application_timers_start(void)
        ret_code_t err_code;
        err_code = app_timer_start(m_app_timer_id, TIMER_INTERVAL, NULL);
        APP_ERROR_CHECK(err_code); */
-    ret_code_t err_code = app_timer_start(m_poll_timer, APP_TIMER_TICKS(60000), NULL);
+    ret_code_t err_code = evt_post_periodic(poll_timer_handler, NULL, EVT_PRIO_LOW, POLL_INTERVAL_MS, POLL_SLACK_MS);
     MI_ERR_CHECK(err_code);
 }
 
@@ -395,16 +439,49 @@ static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
     {
         case BLE_GAP_EVT_DISCONNECTED:
             NRF_LOG_INFO("Disconnected.");
+            gatt_trace_record(GATT_TRACE_DISCONNECT, p_ble_evt->evt.gap_evt.conn_handle,
+                              &p_ble_evt->evt.gap_evt.params.disconnected.reason, 1);
             // LED indication will be changed when advertising starts.
+            adv_sched_conn_state_set(false);
+            kbd_scan_stop();
+            mem_stats_phase_mark(MEM_PHASE_IDLE);
+#if (SESSION_ARENA_ENABLED == 1)
+            // The library handles the disconnect in its own observer, reset once it has.
+            err_code = evt_post(auth_arena_reset, NULL, EVT_PRIO_NORMAL);
+            APP_ERROR_CHECK(err_code);
+#endif
             break;
 
         case BLE_GAP_EVT_CONNECTED:
+        {
             NRF_LOG_INFO("Connected.");
+            ble_gap_addr_t const * p_peer = &p_ble_evt->evt.gap_evt.params.connected.peer_addr;
+            uint8_t peer[1 + BLE_GAP_ADDR_LEN] = {p_peer->addr_type};
+            memcpy(peer + 1, p_peer->addr, BLE_GAP_ADDR_LEN);
+            gatt_trace_record(GATT_TRACE_CONNECT, p_ble_evt->evt.gap_evt.conn_handle, peer, sizeof(peer));
             err_code = bsp_indication_set(BSP_INDICATE_CONNECTED);
             APP_ERROR_CHECK(err_code);
             m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+            adv_sched_conn_state_set(true);
+#if (SESSION_ARENA_ENABLED == 1)
+            // Auth is the first thing a phone does on a new link.
+            err_code = session_arena_begin();
+            if (err_code != NRF_SUCCESS)
+                MI_LOG_WARNING("session arena not used: %d\n", err_code);
+#endif
             err_code = nrf_ble_qwr_conn_handle_assign(&m_qwr, m_conn_handle);
             APP_ERROR_CHECK(err_code);
+        } break;
+
+        case BLE_GATTS_EVT_WRITE:
+        {
+            ble_gatts_evt_write_t const * p_write = &p_ble_evt->evt.gatts_evt.params.write;
+            gatt_trace_record(GATT_TRACE_WRITE, p_write->handle, p_write->data, p_write->len);
+        } break;
+
+        case BLE_GATTS_EVT_HVN_TX_COMPLETE:
+            gatt_trace_record(GATT_TRACE_NOTIFY, p_ble_evt->evt.gatts_evt.conn_handle,
+                              &p_ble_evt->evt.gatts_evt.params.hvn_tx_complete.count, 1);
             break;
 
         case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
@@ -468,6 +545,10 @@ static void ble_stack_init(void)
 
     // Register a handler for BLE events.
     NRF_SDH_BLE_OBSERVER(m_ble_observer, APP_BLE_OBSERVER_PRIO, ble_evt_handler, NULL);
+
+    // Account radio activity from the SoftDevice radio notifications.
+    err_code = energy_stats_init();
+    APP_ERROR_CHECK(err_code);
 }
 
 
@@ -494,8 +575,11 @@ static void bsp_event_handler(bsp_event_t event)
             break; // BSP_EVENT_DISCONNECT
 
         case BSP_EVENT_KEY_0:
-            app_timer_start(m_bindconfirm_timer, APP_TIMER_TICKS(5000), NULL);
+            err_code = evt_post_delayed(bind_confirm_timeout, NULL, EVT_PRIO_NORMAL,
+                                        BIND_CONFIRM_TIMEOUT_MS, BIND_CONFIRM_SLACK_MS);
+            APP_ERROR_CHECK(err_code);
             advertising_init(1);
+            adv_sched_kick();
             break;
 
         case BSP_EVENT_KEY_1:
@@ -507,19 +591,50 @@ static void bsp_event_handler(bsp_event_t event)
             advertising_init(0);
             break;
 
+#if (GATT_TRACE_ENABLED == 1)
+        case BSP_EVENT_KEY_3:
+            err_code = evt_post(gatt_trace_rtt_dump, NULL, EVT_PRIO_LOW);
+            APP_ERROR_CHECK(err_code);
+            break;
+#endif
+
         default:
             break;
     }
 }
 
 
+static volatile bool m_adv_solicited;                                           /**< Requested state of the solicited (bind confirm) bit. */
+static uint32_t      m_adv_data_key = UINT32_MAX;                               /**< Inputs of the payload currently set, UINT32_MAX if none. */
+
+/**@brief Function for building the advertising payload.
+ *
+ * @details With no capability flags and no user data, the payload only depends on the solicited
+ *          bit and the registration state. It is rebuilt only when either of them changed.
+ */
+static void adv_data_update(void * p_context)
+{
+    bool     solicited = m_adv_solicited;
+    uint32_t key       = (uint32_t)solicited | (get_mi_reg_stat() ? 2 : 0);
+
+    if (key == m_adv_data_key)
+        return;
+
+    MI_LOG_INFO("advertising init...\n");
+    if (mibeacon_adv_data_set(solicited, 0, NULL, 0) == 0)
+        m_adv_data_key = key;
+}
+
 /**@brief Function for initializing the Advertising functionality.
+ *
+ * @details The payload is built from the main loop. Requests made before it runs are merged,
+ *          the last one wins.
  */
 static void advertising_init(bool solicited)
 {
-    MI_LOG_INFO("advertising init...\n");
-    mibeacon_adv_data_set(solicited, 0, NULL, 0);
-    return;
+    m_adv_solicited = solicited;
+    if (evt_post(adv_data_update, NULL, EVT_PRIO_NORMAL) != NRF_SUCCESS)
+        MI_LOG_ERROR("advertising init dropped\n");
 }
 
 /**@brief Function for initializing buttons and leds.
@@ -549,6 +664,12 @@ static void buttons_leds_init()
                                              BSP_BUTTON_ACTION_LONG_PUSH,
                                              BSP_EVENT_KEY_2);
     APP_ERROR_CHECK(err_code);
+
+    /* assign BUTTON 4 to dump the GATT trace over RTT, for more details to check bsp_event_handler()*/
+    err_code = bsp_event_to_button_action_assign(3,
+                                             BSP_BUTTON_ACTION_PUSH,
+                                             BSP_EVENT_KEY_3);
+    APP_ERROR_CHECK(err_code);
 }
 
 
@@ -556,10 +677,19 @@ static void buttons_leds_init()
  */
 static void log_init(void)
 {
-    ret_code_t err_code = NRF_LOG_INIT(NULL);
+    ret_code_t err_code = NRF_LOG_INIT(time_log_timestamp);
     APP_ERROR_CHECK(err_code);
 
     NRF_LOG_DEFAULT_BACKENDS_INIT();
+
+#if (MI_LOG_BINARY == 1)
+    bin_log_init();
+#endif
+
+#if (GATT_TRACE_ENABLED == 1)
+    SEGGER_RTT_ConfigUpBuffer(GATT_TRACE_RTT_CHANNEL, "gatt_trace", m_trace_rtt_buf,
+                              sizeof(m_trace_rtt_buf), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+#endif
 }
 
 
@@ -581,16 +711,21 @@ static void idle_state_handle(void)
 {
     if (NRF_LOG_PROCESS() == false)
     {
+        // SoftDevice and radio interrupts end the WFE interval themselves, see energy_stats.h.
+        energy_state_set(ENERGY_STATE_WFE, true);
         nrf_pwr_mgmt_run();
+        energy_state_set(ENERGY_STATE_WFE, false);
     }
 }
 
 
 /**@brief Function for starting advertising.
+ *
+ * @details Starts with a fast burst, the interval then backs off to ADV_SCHED_IDLE_INTERVAL_MS.
  */
 static void advertising_start(void)
 {
-    mibeacon_adv_start(300);
+    adv_sched_start();
 }
 
 
@@ -603,8 +738,19 @@ static void bind_confirm_timeout(void * p_context)
 
 static void poll_timer_handler(void * p_context)
 {
-    time_t utc_time = time(NULL);
-    MI_LOG_INFO("%s", ctime(&utc_time));
+    // Static: deferred logging only keeps the pointer until the log is processed.
+    static char utc_str[TIME_ISO8601_LEN];
+    evt_queue_stats_t stats;
+    evt_queue_stats_get(&stats);
+    time_iso8601(time(NULL), utc_str, sizeof(utc_str));
+    MI_LOG_INFO("%s, drift %d ppb\n", utc_str, time_drift_ppb_get());
+    MI_LOG_INFO("queue timer wakeups %d (%d/h), events %d\n", stats.timer_wakeups, stats.timer_wakeups_per_hour,
+                stats.dispatched);
+
+    mem_stats_t mem;
+    mem_stats_get(&mem);
+    MI_LOG_INFO("stack peak %d/%d, heap %d peak %d/%d\n", mem.stack_peak, mem.stack_size,
+                mem.heap_used, mem.heap_peak, mem.heap_size);
 
     // if device has been registered, it could boardcast mibeacon objects.
     if (get_mi_reg_stat()) {
@@ -613,11 +759,10 @@ static void poll_timer_handler(void * p_context)
     }
 }
 
-void time_init(struct tm * time_ptr);
-
 
 #define PAIRCODE_NUMS 6
-static bool need_kbd_input;
+#define KBD_SCAN_INTERVAL_MS 100
+#define KBD_SCAN_SLACK_MS    20
 static uint8_t pair_code_num;
 static uint8_t pair_code[PAIRCODE_NUMS];
 static const uint8_t qr_code[16] = {
@@ -638,17 +783,89 @@ void flush_keyboard_buffer(void)
     while(SEGGER_RTT_ReadNoLock(0, tmp, 16));
 }
 
+static void kbd_scan_handler(void * p_context)
+{
+    if (pair_code_num < PAIRCODE_NUMS) {
+        pair_code_num += scan_keyboard(pair_code + pair_code_num, PAIRCODE_NUMS - pair_code_num);
+    }
+
+    if (pair_code_num == PAIRCODE_NUMS) {
+        pair_code_num = 0;
+        mi_schd_oob_rsp(pair_code, sizeof(pair_code));
+    } else {
+        // RTT down buffer can't raise an interrupt, keep polling until the code is complete.
+        ret_code_t err_code = evt_post_delayed(kbd_scan_handler, NULL, EVT_PRIO_LOW,
+                                               KBD_SCAN_INTERVAL_MS, KBD_SCAN_SLACK_MS);
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+#if (SESSION_ARENA_ENABLED == 1)
+/* Ends the auth session arena, see session_arena.h. */
+static void auth_arena_end(void)
+{
+    if (session_arena_end() == NRF_ERROR_BUSY)
+        MI_LOG_WARNING("session arena: blocks still live, cleared when freed\n");
+}
+
+/* Runs from the main loop after a disconnect, when every BLE observer has seen the event. Blocks
+ * still live then are leaked by the library and would keep the arena from serving later auths. */
+static void auth_arena_reset(void * p_context)
+{
+    uint32_t dropped = session_arena_reset();
+
+    if (dropped != 0)
+        MI_LOG_ERROR("session arena: %d leaked blocks dropped\n", dropped);
+}
+
+/* Brackets the arena around the auth steps: lock operations and mibeacon objects that follow a
+ * login are not part of the session. */
+static void auth_arena_update(uint16_t id)
+{
+    switch (id) {
+    case SCHD_EVT_REG_SUCCESS:
+    case SCHD_EVT_REG_FAILED:
+    case SCHD_EVT_ADMIN_LOGIN_SUCCESS:
+    case SCHD_EVT_ADMIN_LOGIN_FAILED:
+    case SCHD_EVT_SHARE_LOGIN_SUCCESS:
+    case SCHD_EVT_SHARE_LOGIN_FAILED:
+    case SCHD_EVT_TIMEOUT:
+        auth_arena_end();
+        break;
+
+    default:
+        break;
+    }
+}
+#endif
+
+/* Ends pair code polling when the pairing it was started for is over. */
+static void kbd_scan_stop(void)
+{
+    evt_cancel(kbd_scan_handler, NULL);
+    pair_code_num = 0;
+}
+
 
 void mi_schd_event_handler(schd_evt_t *p_event)
 {
+    ret_code_t err_code;
+
     MI_LOG_INFO("USER CUSTOM CALLBACK RECV EVT ID %d\n", p_event->id);
+    gatt_trace_record(GATT_TRACE_AUTH, p_event->id, NULL, 0);
+    mem_stats_phase_mark(p_event->id);
+#if (SESSION_ARENA_ENABLED == 1)
+    auth_arena_update(p_event->id);
+#endif
     switch (p_event->id) {
     case SCHD_EVT_OOB_REQUEST:
         MI_LOG_INFO("App selected IO cap is 0x%04X\n", p_event->data.IO_capability);
         switch (p_event->data.IO_capability) {
         case 0x0001:
-            need_kbd_input = true;
+            pair_code_num = 0;
             flush_keyboard_buffer();
+            err_code = evt_post_delayed(kbd_scan_handler, NULL, EVT_PRIO_LOW, KBD_SCAN_INTERVAL_MS, KBD_SCAN_SLACK_MS);
+            APP_ERROR_CHECK(err_code);
             MI_LOG_INFO(MI_LOG_COLOR_GREEN "Please input your pair code ( MUST be 6 digits ) : \n");
             break;
 
@@ -672,6 +889,12 @@ void mi_schd_event_handler(schd_evt_t *p_event)
         advertising_init(0);
         break;
 
+    case SCHD_EVT_REG_FAILED:
+    case SCHD_EVT_TIMEOUT:
+        // Aborted pairing: a pair code typed from now on belongs to no request.
+        kbd_scan_stop();
+        break;
+
     default:
         break;
     }
@@ -702,6 +925,7 @@ int mijia_secure_chip_power_manage(bool power_stat)
     } else {
         nrf_gpio_pin_clear(MSC_PWR_PIN);
     }
+    energy_state_set(ENERGY_STATE_MSC, power_stat);
     return 0;
 }
 
@@ -736,6 +960,7 @@ void ble_lock_ops_handler(uint8_t opcode)
     obj_lock_event.user_id= get_mi_key_id();
     obj_lock_event.time   = time(NULL);
 
+    // Lock operations arrive while connected, the event goes out in the burst after the disconnect.
     mibeacon_obj_enque(MI_EVT_LOCK, sizeof(obj_lock_event), &obj_lock_event, 0);
             
     reply_lock_stat(opcode);
@@ -743,16 +968,234 @@ void ble_lock_ops_handler(uint8_t opcode)
     MI_ERR_CHECK(errno);
 }
 
-void stdio_rx_handler(uint8_t* p, uint8_t l)
+#if (GATT_TRACE_ENABLED == 1)
+static int trace_rtt_out(const uint8_t * p_data, uint8_t len)
+{
+    // Skip mode drops whole records, the host side stays aligned to record boundaries.
+    return SEGGER_RTT_Write(GATT_TRACE_RTT_CHANNEL, p_data, len) == len ? 0 : -1;
+}
+
+static void gatt_trace_rtt_dump(void * p_context)
+{
+    uint32_t cnt = gatt_trace_dump(trace_rtt_out);
+    MI_LOG_INFO("gatt trace: %d records dumped to RTT channel %d\n", cnt, GATT_TRACE_RTT_CHANNEL);
+}
+#endif
+
+/* Formats a report line without libc printf. Supports %s, and %u and %x with an optional
+ * zero padded width as in %03u. Output stops at @p size, the line is not NUL terminated. */
+static uint8_t line_fmt(char * p_line, uint8_t size, const char * p_fmt, ...)
+{
+    va_list args;
+    uint8_t len = 0;
+
+    va_start(args, p_fmt);
+    for (; *p_fmt != '\0' && len < size; p_fmt++) {
+        if (*p_fmt != '%') {
+            p_line[len++] = *p_fmt;
+            continue;
+        }
+
+        uint8_t width = 0;
+        while (p_fmt[1] >= '0' && p_fmt[1] <= '9')
+            width = width * 10 + (*++p_fmt - '0');
+        if (*++p_fmt == '\0')
+            break;
+
+        if (*p_fmt == 's') {
+            const char * p_str = va_arg(args, const char *);
+            while (*p_str != '\0' && len < size)
+                p_line[len++] = *p_str++;
+        } else {
+            uint32_t val  = va_arg(args, uint32_t);
+            uint32_t base = (*p_fmt == 'x') ? 16 : 10;
+            char     digits[10];
+            uint8_t  n = 0;
+
+            do {
+                digits[n++] = "0123456789abcdef"[val % base];
+                val /= base;
+            } while ((val != 0 || n < width) && n < sizeof(digits));
+            while (n > 0 && len < size)
+                p_line[len++] = digits[--n];
+        }
+    }
+    va_end(args);
+
+    return len;
+}
+
+/* Writes line @p idx of a report, returns 0 past the last line. */
+typedef uint8_t (*report_line_t)(uint32_t idx, char * p_line, uint8_t size);
+
+static struct {
+    report_line_t line;                 /* NULL while no report is being sent. */
+    uint32_t      next;                 /* Next line to send. */
+    uint8_t       retries;              /* Failed sends of that line. */
+} m_report;
+
+static energy_stats_t m_energy_snapshot;
+
+static uint8_t energy_report_line(uint32_t idx, char * p_line, uint8_t size)
+{
+    if (idx == 0)
+        return line_fmt(p_line, size, "uptime %us", m_energy_snapshot.uptime_s);
+
+    // One frame per state: "<state> <seconds>s <charge>uAh"
+    if (--idx < ENERGY_STATE_COUNT)
+        return line_fmt(p_line, size, "%s %us %u.%03uuAh", energy_state_name((energy_state_t)idx),
+                        m_energy_snapshot.time_s[idx], m_energy_snapshot.charge_nah[idx] / 1000,
+                        m_energy_snapshot.charge_nah[idx] % 1000);
+
+    return 0;
+}
+
+#if (STDIO_DEBUG_CMDS == 1)
+static mem_stats_t m_mem_snapshot;
+#if (SESSION_ARENA_ENABLED == 1)
+static session_arena_stats_t m_arena_snapshot;
+#endif
+
+static uint8_t mem_report_line(uint32_t idx, char * p_line, uint8_t size)
+{
+    mem_stats_site_t const * p_site;
+    mem_stats_phase_t const * p_phase;
+    uint32_t n;
+
+    if (idx == 0)
+        return line_fmt(p_line, size, "stack %u/%u", m_mem_snapshot.stack_peak, m_mem_snapshot.stack_size);
+    if (idx == 1)
+        return line_fmt(p_line, size, "heap %u/%u/%u fail %u", m_mem_snapshot.heap_used,
+                        m_mem_snapshot.heap_peak, m_mem_snapshot.heap_size, m_mem_snapshot.heap_failures);
+    idx -= 2;
+
+#if (MEM_POOL_ENABLED == 1)
+    // "pool <block size> <used>/<count> peak <peak> fail <failures>"
+    if (idx < MEM_POOL_CLASSES) {
+        mem_pool_stats_t const * p_pool = mem_pool_stats_get(idx);
+        return line_fmt(p_line, size, "pool %u %u/%u peak %u fail %u", p_pool->block_size,
+                        p_pool->used, p_pool->count, p_pool->peak, p_pool->failures);
+    }
+    idx -= MEM_POOL_CLASSES;
+#endif
+
+#if (SESSION_ARENA_ENABLED == 1)
+    switch (idx) {
+    case 0:
+        return line_fmt(p_line, size, "arena %u/%u last %u ovf %u", m_arena_snapshot.peak,
+                        SESSION_ARENA_SIZE, m_arena_snapshot.last_peak, m_arena_snapshot.overflows);
+    case 1:
+        return line_fmt(p_line, size, "arena sessions %u busy %u stale %u", m_arena_snapshot.sessions,
+                        m_arena_snapshot.busy, m_arena_snapshot.stale_frees);
+    case 2:
+        return line_fmt(p_line, size, "arena resets %u dropped %u", m_arena_snapshot.resets,
+                        m_arena_snapshot.dropped);
+    default:
+        idx -= 3;
+    }
+#endif
+
+    // "site <return address> <allocs> <peak bytes>"
+    if ((p_site = mem_stats_site_get(idx)) != NULL)
+        return line_fmt(p_line, size, "site %08x %u %u", p_site->site, p_site->allocs, p_site->peak);
+    n = 0;
+    while (mem_stats_site_get(n) != NULL)
+        n++;
+    idx -= n;
+
+    // "phase <id> x<count> <stack peak> <heap peak>"
+    if ((p_phase = mem_stats_phase_get(idx)) != NULL)
+        return line_fmt(p_line, size, "phase %u x%u %u %u", p_phase->id, p_phase->count,
+                        p_phase->stack_peak, p_phase->heap_peak);
+
+    return 0;
+}
+#endif
+
+/* Sends the lines of the running report. A line the transport does not take is retried later,
+ * the report is given up with a warning if it keeps failing. */
+static void stdio_report_send(void * p_context)
+{
+    char line[40];
+    uint8_t len;
+
+    while ((len = m_report.line(m_report.next, line, sizeof(line))) != 0) {
+        if (stdio_tx((uint8_t *)line, len) != 0) {
+            if (++m_report.retries > STDIO_REPORT_RETRIES) {
+                MI_LOG_WARNING("stdio report truncated at line %d\n", m_report.next);
+                m_report.line = NULL;
+                return;
+            }
+            ret_code_t err_code = evt_post_delayed(stdio_report_send, NULL, EVT_PRIO_LOW,
+                                                   STDIO_REPORT_RETRY_MS, STDIO_REPORT_RETRY_SLACK_MS);
+            APP_ERROR_CHECK(err_code);
+            return;
+        }
+        m_report.retries = 0;
+        m_report.next++;
+    }
+
+    m_report.line = NULL;
+}
+
+static void stdio_report_start(report_line_t line)
+{
+    if (m_report.line != NULL) {
+        MI_LOG_WARNING("stdio report still being sent\n");
+        return;
+    }
+
+    m_report.line    = line;
+    m_report.next    = 0;
+    m_report.retries = 0;
+    stdio_report_send(NULL);
+}
+
+/* Handles the frames queued by stdio_rx_handler(), each stored as | len:8 | data |. */
+static void stdio_rx_process(void * p_context)
 {
     int errno;
-    /* RX plain text (It has been decrypted) */
-    MI_LOG_INFO("RX raw data\n");
-    MI_LOG_HEXDUMP(p, l);
+    uint8_t l;
+    uint8_t p[UINT8_MAX];
 
-    /* TX plain text (It will be encrypted before send out.) */
-    errno = stdio_tx(p, l);
-    MI_ERR_CHECK(errno);
+    while (spsc_ring_pop(&m_stdio_rx_ring, &l, sizeof(l)) == sizeof(l)) {
+        spsc_ring_pop(&m_stdio_rx_ring, p, l);
+
+        if (l == strlen(ENERGY_STDIO_CMD) && memcmp(p, ENERGY_STDIO_CMD, l) == 0) {
+            energy_stats_get(&m_energy_snapshot);
+            stdio_report_start(energy_report_line);
+            continue;
+        }
+
+#if (STDIO_DEBUG_CMDS == 1)
+        if (l == strlen(MEM_STDIO_CMD) && memcmp(p, MEM_STDIO_CMD, l) == 0) {
+            mem_stats_get(&m_mem_snapshot);
+#if (SESSION_ARENA_ENABLED == 1)
+            session_arena_stats_get(&m_arena_snapshot);
+#endif
+            stdio_report_start(mem_report_line);
+            continue;
+        }
+#endif
+
+        /* TX plain text (It will be encrypted before send out.) */
+        errno = stdio_tx(p, l);
+        MI_ERR_CHECK(errno);
+    }
+}
+
+void stdio_rx_handler(uint8_t* p, uint8_t l)
+{
+    /* RX plain text (It has been decrypted), only its length goes to the trace. */
+    gatt_trace_record(GATT_TRACE_STDIO_RX, 0, NULL, l);
+
+    /* Length and data are published together, the main loop never sees one without the other. */
+    if (spsc_ring_push2(&m_stdio_rx_ring, &l, sizeof(l), p, l) != NRF_SUCCESS) {
+        MI_LOG_WARNING("stdio rx frame dropped\n");
+        return;
+    }
+    if (evt_post(stdio_rx_process, NULL, EVT_PRIO_NORMAL) != NRF_SUCCESS)
+        MI_LOG_ERROR("stdio rx process dropped\n");
 }
 
 /**@brief Function for application main entry.
@@ -761,6 +1204,10 @@ int main(void)
 {
 
     // Initialize.
+    mem_stats_init();
+#if (MEM_POOL_ENABLED == 1)
+    mem_pool_init();
+#endif
     log_init();
     timers_init();
     MI_LOG_INFO(RTT_CTRL_CLEAR"Compiled  %s %s\n", (uint32_t)__DATE__, (uint32_t)__TIME__);
@@ -769,7 +1216,8 @@ int main(void)
     ble_stack_init();
     gap_params_init();
     gatt_init();
-    advertising_init(0);
+    // Build the payload now, it must be set before advertising starts.
+    adv_data_update(NULL);
     services_init();
     conn_params_init();
 
@@ -798,17 +1246,8 @@ int main(void)
     
     // Enter main loop.
     for (;;) {
-        // Scan keyboard.
-        if (need_kbd_input) {
-            if (pair_code_num < PAIRCODE_NUMS) {
-                pair_code_num += scan_keyboard(pair_code + pair_code_num, PAIRCODE_NUMS - pair_code_num);
-            }
-            if (pair_code_num == PAIRCODE_NUMS) {
-                pair_code_num = 0;
-                need_kbd_input = false;
-                mi_schd_oob_rsp(pair_code, sizeof(pair_code));
-            }
-        }
+        // Dispatch due application events, e.g. keyboard scan.
+        evt_queue_process();
 
 #if (MI_SCHD_PROCESS_IN_MAIN_LOOP==1)
         // Process mi scheduler
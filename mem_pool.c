@@ -0,0 +1,255 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nordic_common.h"
+#include "app_error.h"
+#include "nrf_balloc.h"
+#include "app_util_platform.h"
+#include "session_arena.h"
+#include "mem_stats.h"
+#include "mem_pool.h"
+
+#if defined(__CC_ARM)
+#define MALLOC_WRAPPER              $Sub$$malloc
+#define MALLOC_REAL                 $Super$$malloc
+#define FREE_WRAPPER                $Sub$$free
+#define FREE_REAL                   $Super$$free
+#define CALLOC_WRAPPER              $Sub$$calloc
+#define REALLOC_WRAPPER             $Sub$$realloc
+#define REALLOC_REAL                $Super$$realloc
+#define RETURN_ADDRESS()            ((uintptr_t)__return_address())
+#elif defined(__GNUC__)
+/* Link with -Wl,--wrap=malloc,--wrap=free,--wrap=calloc,--wrap=realloc. */
+#define MALLOC_WRAPPER              __wrap_malloc
+#define MALLOC_REAL                 __real_malloc
+#define FREE_WRAPPER                __wrap_free
+#define FREE_REAL                   __real_free
+#define CALLOC_WRAPPER              __wrap_calloc
+#define REALLOC_WRAPPER             __wrap_realloc
+#define REALLOC_REAL                __real_realloc
+#define RETURN_ADDRESS()            ((uintptr_t)__builtin_return_address(0))
+#endif
+
+void * MALLOC_REAL(size_t size);
+void   FREE_REAL(void * p);
+void * REALLOC_REAL(void * p, size_t size);
+void * MALLOC_WRAPPER(size_t size);
+void   FREE_WRAPPER(void * p);
+void * CALLOC_WRAPPER(size_t count, size_t size);
+void * REALLOC_WRAPPER(void * p, size_t size);
+
+#if (MEM_POOL_ENABLED == 1)
+
+NRF_BALLOC_DEF(m_pool_32,  32,  MEM_POOL_COUNT_32);
+NRF_BALLOC_DEF(m_pool_64,  64,  MEM_POOL_COUNT_64);
+NRF_BALLOC_DEF(m_pool_128, 128, MEM_POOL_COUNT_128);
+NRF_BALLOC_DEF(m_pool_256, 256, MEM_POOL_COUNT_256);
+
+STATIC_ASSERT(MEM_POOL_BYTES <= MEM_POOL_BUDGET);
+
+static const uint16_t m_counts[MEM_POOL_CLASSES] = {
+    MEM_POOL_COUNT_32, MEM_POOL_COUNT_64, MEM_POOL_COUNT_128, MEM_POOL_COUNT_256,
+};
+
+static nrf_balloc_t const * const m_pools[MEM_POOL_CLASSES] = {
+    &m_pool_32, &m_pool_64, &m_pool_128, &m_pool_256,
+};
+
+static mem_pool_stats_t m_stats[MEM_POOL_CLASSES];
+
+void mem_pool_init(void)
+{
+    for (int i = 0; i < MEM_POOL_CLASSES; i++) {
+        APP_ERROR_CHECK(nrf_balloc_init(m_pools[i]));
+        m_stats[i].block_size = 32 << i;
+        m_stats[i].count      = m_counts[i];
+    }
+}
+
+void * mem_pool_alloc(size_t size)
+{
+    void * p   = NULL;
+    int    cls = 0;
+
+    if (size == 0 || size > MEM_POOL_MAX_BLOCK)
+        return NULL;
+
+    while (size > (32u << cls))
+        cls++;
+
+    CRITICAL_REGION_ENTER();
+    if (m_stats[cls].used == m_stats[cls].count)
+        m_stats[cls].failures++;
+
+    /* A larger block is better than the heap. */
+    for (int i = cls; i < MEM_POOL_CLASSES && p == NULL; i++) {
+        if (m_stats[i].used == m_stats[i].count)
+            continue;
+        p = nrf_balloc_alloc(m_pools[i]);
+        if (p != NULL) {
+            m_stats[i].used++;
+            m_stats[i].peak = MAX(m_stats[i].peak, m_stats[i].used);
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    return p;
+}
+
+static int pool_find(void const * p)
+{
+    for (int i = 0; i < MEM_POOL_CLASSES; i++) {
+        uint8_t const * p_begin = m_pools[i]->p_memory_begin;
+        uint8_t const * p_end   = p_begin + m_pools[i]->block_size * m_stats[i].count;
+
+        if ((uint8_t const *)p >= p_begin && (uint8_t const *)p < p_end)
+            return i;
+    }
+    return -1;
+}
+
+bool mem_pool_free(void * p)
+{
+    int i = pool_find(p);
+
+    if (i < 0)
+        return false;
+
+    CRITICAL_REGION_ENTER();
+    nrf_balloc_free(m_pools[i], p);
+    m_stats[i].used--;
+    CRITICAL_REGION_EXIT();
+    return true;
+}
+
+size_t mem_pool_block_size(void const * p)
+{
+    int i = pool_find(p);
+    return i < 0 ? 0 : m_stats[i].block_size;
+}
+
+mem_pool_stats_t const * mem_pool_stats_get(uint32_t idx)
+{
+    return idx < MEM_POOL_CLASSES ? &m_stats[idx] : NULL;
+}
+
+#endif // MEM_POOL_ENABLED
+
+/* Serves a request from the session arena, the pools, then the C heap. */
+static void * route_alloc(size_t size)
+{
+    void * p = NULL;
+
+#if (SESSION_ARENA_ENABLED == 1)
+    p = session_arena_alloc(size);
+#endif
+#if (MEM_POOL_ENABLED == 1)
+    if (p == NULL)
+        p = mem_pool_alloc(size);
+#endif
+    if (p == NULL)
+        p = MALLOC_REAL(size);
+
+    return p;
+}
+
+static void route_free(void * p)
+{
+#if (SESSION_ARENA_ENABLED == 1)
+    if (session_arena_free(p))
+        return;
+#endif
+#if (MEM_POOL_ENABLED == 1)
+    if (mem_pool_free(p))
+        return;
+#endif
+    FREE_REAL(p);
+}
+
+/* Usable size of an arena or pool block, 0 for C heap blocks. */
+static size_t route_block_size(void const * p)
+{
+    size_t block_size = 0;
+
+#if (SESSION_ARENA_ENABLED == 1)
+    block_size = session_arena_block_size(p);
+#endif
+#if (MEM_POOL_ENABLED == 1)
+    if (block_size == 0)
+        block_size = mem_pool_block_size(p);
+#endif
+
+    return block_size;
+}
+
+void * MALLOC_WRAPPER(size_t size)
+{
+    void * p = route_alloc(size);
+
+    mem_stats_on_alloc(p, size, RETURN_ADDRESS());
+    return p;
+}
+
+void FREE_WRAPPER(void * p)
+{
+    if (p == NULL)
+        return;
+
+    mem_stats_on_free(p);
+    route_free(p);
+}
+
+/* Wrapped on its own: mbedtls allocates through calloc(), and the GCC C library does not route
+ * calloc() through the malloc() symbol. */
+void * CALLOC_WRAPPER(size_t count, size_t size)
+{
+    size_t total = count * size;
+    void * p     = NULL;
+
+    if (size == 0 || total / size == count) {
+        p = route_alloc(total);
+        if (p != NULL)
+            memset(p, 0, total);
+    }
+
+    mem_stats_on_alloc(p, total, RETURN_ADDRESS());
+    return p;
+}
+
+/* Heap blocks are resized by the C library. It cannot resize pool or arena blocks, those are
+ * moved. Either way the accounting follows the block to its new address. */
+void * REALLOC_WRAPPER(void * p, size_t size)
+{
+    uintptr_t site = RETURN_ADDRESS();
+    void *    p_new;
+
+    if (p == NULL) {
+        p_new = route_alloc(size);
+        mem_stats_on_alloc(p_new, size, site);
+        return p_new;
+    }
+
+    if (size == 0) {
+        FREE_WRAPPER(p);
+        return NULL;
+    }
+
+    size_t block_size = route_block_size(p);
+    if (block_size == 0) {
+        p_new = REALLOC_REAL(p, size);
+    } else {
+        p_new = route_alloc(size);
+        if (p_new != NULL) {
+            memcpy(p_new, p, MIN(block_size, size));
+            route_free(p);
+        }
+    }
+
+    /* On failure the old block stays valid and accounted. */
+    if (p_new != NULL)
+        mem_stats_on_free(p);
+    mem_stats_on_alloc(p_new, size, site);
+    return p_new;
+}
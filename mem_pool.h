@@ -0,0 +1,101 @@
+/**@file
+ *
+ * @brief Fixed size class pools for the heap users.
+ *
+ * @details Requests are served from the smallest nrf_balloc pool whose blocks fit, or from the
+ *          next larger class if that one is exhausted, in O(1) and without fragmentation.
+ *
+ *          This module also owns the C library allocator wrappers: malloc(), free(), calloc()
+ *          and realloc() are intercepted at link time ($Sub$$ with armcc, --wrap with GCC).
+ *          They serve requests from the session arena, then the pools, and fall back to the C
+ *          heap only for requests larger than the biggest class or when all fitting pools are
+ *          empty. Every call is reported to mem_stats, which compiles to nothing with
+ *          MEM_STATS_ENABLED 0.
+ *
+ *          Block counts are planned per chip at compile time. The total must fit
+ *          MEM_POOL_BUDGET, which is checked by the build. The pools come on top of the C heap,
+ *          which still serves every request above 256 bytes, so __HEAP_SIZE stays as it is
+ *          until the peak of the "mem" report of mem_stats shows how much of it is left unused.
+ *          The nRF52810 has no RAM to spare for both, its pools are off by default. Use the
+ *          per-site report to size the classes for the auth and transfer buffers actually
+ *          requested.
+ */
+#ifndef MEM_POOL_H__
+#define MEM_POOL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MEM_POOL_ENABLED
+#if defined(NRF52810_XXAA)
+#define MEM_POOL_ENABLED                0
+#else
+#define MEM_POOL_ENABLED                1
+#endif
+#endif
+
+#if defined(NRF52810_XXAA)
+#define MEM_POOL_DEFAULT_COUNT_32       4
+#define MEM_POOL_DEFAULT_COUNT_64       4
+#define MEM_POOL_DEFAULT_COUNT_128      2
+#define MEM_POOL_DEFAULT_COUNT_256      1
+#define MEM_POOL_DEFAULT_BUDGET         1024
+#else
+#define MEM_POOL_DEFAULT_COUNT_32       8
+#define MEM_POOL_DEFAULT_COUNT_64       8
+#define MEM_POOL_DEFAULT_COUNT_128      4
+#define MEM_POOL_DEFAULT_COUNT_256      4
+#define MEM_POOL_DEFAULT_BUDGET         4096
+#endif
+
+#ifndef MEM_POOL_COUNT_32
+#define MEM_POOL_COUNT_32               MEM_POOL_DEFAULT_COUNT_32               /**< Number of 32 byte blocks. */
+#endif
+#ifndef MEM_POOL_COUNT_64
+#define MEM_POOL_COUNT_64               MEM_POOL_DEFAULT_COUNT_64
+#endif
+#ifndef MEM_POOL_COUNT_128
+#define MEM_POOL_COUNT_128              MEM_POOL_DEFAULT_COUNT_128
+#endif
+#ifndef MEM_POOL_COUNT_256
+#define MEM_POOL_COUNT_256              MEM_POOL_DEFAULT_COUNT_256
+#endif
+#ifndef MEM_POOL_BUDGET
+#define MEM_POOL_BUDGET                 MEM_POOL_DEFAULT_BUDGET                 /**< RAM all pools together may take, in bytes. */
+#endif
+
+#define MEM_POOL_BYTES                  (32 * MEM_POOL_COUNT_32 + 64 * MEM_POOL_COUNT_64 +     \
+                                         128 * MEM_POOL_COUNT_128 + 256 * MEM_POOL_COUNT_256)
+
+#define MEM_POOL_CLASSES                4
+#define MEM_POOL_MAX_BLOCK              256
+
+typedef struct {
+    uint16_t block_size;
+    uint16_t count;
+    uint16_t used;
+    uint16_t peak;
+    uint32_t failures;                  /**< Requests of this class that found its pool empty. */
+} mem_pool_stats_t;
+
+/**@brief Function for initializing the pools. Must run before the first malloc(). */
+void mem_pool_init(void);
+
+/**@brief Function for allocating a block of at least @p size bytes, NULL if no pool can serve it. */
+void * mem_pool_alloc(size_t size);
+
+/**@brief Function for releasing a block.
+ *
+ * @retval true   The block belonged to a pool and was released.
+ * @retval false  The block was not allocated by mem_pool_alloc().
+ */
+bool mem_pool_free(void * p);
+
+/**@brief Function for getting the usable size of a pool block, 0 if @p p is not one. */
+size_t mem_pool_block_size(void const * p);
+
+/**@brief Function for reading the statistics of size class @p idx, NULL past the last class. */
+mem_pool_stats_t const * mem_pool_stats_get(uint32_t idx);
+
+#endif // MEM_POOL_H__
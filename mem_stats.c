@@ -0,0 +1,194 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nordic_common.h"
+#include "nrf.h"
+#include "app_util.h"
+#include "app_util_platform.h"
+#include "mem_stats.h"
+
+#if (MEM_STATS_ENABLED == 1)
+
+#define STACK_FILL                  0xCDCDCDCD
+#define STACK_PAINT_MARGIN          64          /* Below the SP, covers this function's callees. */
+
+/* Stack bounds are STACK_BASE and STACK_TOP of app_util.h, as used by nrf_stack_guard. */
+#define STACK_START                 ((uint32_t *)STACK_BASE)
+#define STACK_END                   ((uint32_t *)STACK_TOP)
+
+#if defined(__CC_ARM)
+extern uint32_t HEAP$$Base;
+extern uint32_t HEAP$$Limit;
+#define HEAP_BASE                   (&HEAP$$Base)
+#define HEAP_LIMIT                  (&HEAP$$Limit)
+#elif defined(__GNUC__)
+extern uint32_t __HeapBase;
+extern uint32_t __HeapLimit;
+#define HEAP_BASE                   (&__HeapBase)
+#define HEAP_LIMIT                  (&__HeapLimit)
+#endif
+
+typedef struct {
+    void const * p;
+    uint16_t     size;
+    uint8_t      site;                  /* Index in m_sites, MEM_STATS_SITES if not tracked. */
+} block_t;
+
+static block_t           m_blocks[MEM_STATS_BLOCKS];
+static mem_stats_site_t  m_sites[MEM_STATS_SITES];
+static mem_stats_phase_t m_phases[MEM_STATS_PHASES];
+static mem_stats_phase_t * mp_phase;
+
+static uint32_t m_stack_peak;
+static uint32_t m_heap_used;
+static uint32_t m_heap_peak;
+static uint32_t m_phase_heap_peak;
+static uint32_t m_heap_failures;
+static uint32_t m_untracked;
+
+static void stack_paint(uint32_t margin)
+{
+    uint32_t * p     = STACK_START;
+    uint32_t * p_end = (uint32_t *)((__get_MSP() - margin) & ~3UL);
+
+    while (p < p_end)
+        *p++ = STACK_FILL;
+}
+
+static uint32_t stack_used(void)
+{
+    uint32_t const * p = STACK_START;
+
+    while (p < STACK_END && *p == STACK_FILL)
+        p++;
+
+    return (uintptr_t)STACK_END - (uintptr_t)p;
+}
+
+void mem_stats_init(void)
+{
+    /* Nothing runs below main() yet, a small margin is enough. */
+    stack_paint(STACK_PAINT_MARGIN);
+}
+
+static uint8_t site_index(uintptr_t site)
+{
+    uint8_t i;
+
+    for (i = 0; i < MEM_STATS_SITES; i++) {
+        if (m_sites[i].site == site)
+            return i;
+        if (m_sites[i].site == 0) {
+            m_sites[i].site = site;
+            return i;
+        }
+    }
+    return MEM_STATS_SITES;
+}
+
+void mem_stats_on_alloc(void const * p, size_t size, uintptr_t site)
+{
+    CRITICAL_REGION_ENTER();
+    if (p == NULL) {
+        m_heap_failures++;
+    } else {
+        block_t * p_blk = NULL;
+        for (int i = 0; i < MEM_STATS_BLOCKS && p_blk == NULL; i++) {
+            if (m_blocks[i].p == NULL)
+                p_blk = &m_blocks[i];
+        }
+
+        if (p_blk == NULL) {
+            m_untracked++;
+        } else {
+            p_blk->p    = p;
+            p_blk->size = size;
+            p_blk->site = site_index(site);
+            if (p_blk->site < MEM_STATS_SITES) {
+                mem_stats_site_t * p_site = &m_sites[p_blk->site];
+                p_site->allocs++;
+                p_site->used += size;
+                p_site->peak  = MAX(p_site->peak, p_site->used);
+            }
+            m_heap_used      += size;
+            m_heap_peak       = MAX(m_heap_peak, m_heap_used);
+            m_phase_heap_peak = MAX(m_phase_heap_peak, m_heap_used);
+        }
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+void mem_stats_on_free(void const * p)
+{
+    CRITICAL_REGION_ENTER();
+    for (int i = 0; p != NULL && i < MEM_STATS_BLOCKS; i++) {
+        block_t * p_blk = &m_blocks[i];
+        if (p_blk->p != p)
+            continue;
+
+        if (p_blk->site < MEM_STATS_SITES)
+            m_sites[p_blk->site].used -= p_blk->size;
+        m_heap_used -= p_blk->size;
+        p_blk->p = NULL;
+        break;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+void mem_stats_get(mem_stats_t * p_stats)
+{
+    m_stack_peak = MAX(m_stack_peak, stack_used());
+
+    p_stats->stack_size    = (uintptr_t)STACK_END - (uintptr_t)STACK_START;
+    p_stats->stack_peak    = m_stack_peak;
+    p_stats->heap_size     = (uintptr_t)HEAP_LIMIT - (uintptr_t)HEAP_BASE;
+    p_stats->heap_used     = m_heap_used;
+    p_stats->heap_peak     = m_heap_peak;
+    p_stats->heap_failures = m_heap_failures;
+    p_stats->untracked     = m_untracked;
+}
+
+mem_stats_site_t const * mem_stats_site_get(uint32_t idx)
+{
+    if (idx >= MEM_STATS_SITES || m_sites[idx].site == 0)
+        return NULL;
+    return &m_sites[idx];
+}
+
+void mem_stats_phase_mark(uint16_t id)
+{
+    uint32_t used = stack_used();
+
+    /* Marked from the SoftDevice event handler and from the main loop. */
+    CRITICAL_REGION_ENTER();
+    m_stack_peak = MAX(m_stack_peak, used);
+    if (mp_phase != NULL) {
+        mp_phase->stack_peak = MAX(mp_phase->stack_peak, used);
+        mp_phase->heap_peak  = MAX(mp_phase->heap_peak, m_phase_heap_peak);
+    }
+
+    mp_phase = NULL;
+    for (int i = 0; i < MEM_STATS_PHASES && mp_phase == NULL; i++) {
+        if (m_phases[i].count == 0 || m_phases[i].id == id)
+            mp_phase = &m_phases[i];
+    }
+    if (mp_phase != NULL) {
+        mp_phase->id = id;
+        mp_phase->count++;
+    }
+    m_phase_heap_peak = m_heap_used;
+    CRITICAL_REGION_EXIT();
+
+    /* Outside the critical region, painting the stack takes a while. */
+    stack_paint(MEM_STATS_REPAINT_MARGIN);
+}
+
+mem_stats_phase_t const * mem_stats_phase_get(uint32_t idx)
+{
+    if (idx >= MEM_STATS_PHASES || m_phases[idx].count == 0)
+        return NULL;
+    return &m_phases[idx];
+}
+
+#endif // MEM_STATS_ENABLED
@@ -0,0 +1,132 @@
+/**@file
+ *
+ * @brief Stack and heap usage instrumentation.
+ *
+ * @details The unused part of the main stack is painted with a known pattern at boot. The high
+ *          water mark is the deepest word that no longer holds the pattern. The allocator
+ *          wrappers in mem_pool.c report every heap call, which is accounted per call site. The
+ *          heap figures cover the session arena and pool blocks too.
+ *
+ *          With MEM_STATS_ENABLED 0 the functions compile to nothing and the allocator works
+ *          without the instrumentation.
+ *
+ *          The application can split run time into phases, e.g. one per secure auth step, with
+ *          mem_stats_phase_mark(). The stack is repainted at each mark, so the peaks recorded for
+ *          a phase only cover that phase. The overall high water mark is kept across repaints.
+ *          Interrupts may preempt the repaint, so MEM_STATS_REPAINT_MARGIN bytes below the stack
+ *          pointer are left alone and a phase stack peak is never reported below that depth.
+ */
+#ifndef MEM_STATS_H__
+#define MEM_STATS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef MEM_STATS_ENABLED
+#define MEM_STATS_ENABLED               1
+#endif
+
+#ifndef MEM_STATS_SITES
+#define MEM_STATS_SITES                 8                                       /**< Heap call sites tracked, further sites only count in the totals. */
+#endif
+#ifndef MEM_STATS_BLOCKS
+#define MEM_STATS_BLOCKS                32                                      /**< Live heap blocks whose size and site are remembered. */
+#endif
+#ifndef MEM_STATS_REPAINT_MARGIN
+#define MEM_STATS_REPAINT_MARGIN        2048                                    /**< Stack kept below the SP when repainting, for nested interrupts incl. the SoftDevice. */
+#endif
+#ifndef MEM_STATS_PHASES
+#define MEM_STATS_PHASES                8                                       /**< Distinct phase ids with their own peaks. */
+#endif
+
+typedef struct {
+    uint32_t stack_size;
+    uint32_t stack_peak;                /**< Deepest stack use since boot, in bytes. */
+    uint32_t heap_size;
+    uint32_t heap_used;                 /**< Bytes in live blocks, without allocator overhead. */
+    uint32_t heap_peak;
+    uint32_t heap_failures;             /**< malloc() calls that returned NULL. */
+    uint32_t untracked;                 /**< Blocks not accounted because the block table was full. */
+} mem_stats_t;
+
+typedef struct {
+    uintptr_t site;                     /**< Return address of the malloc() call, 0 if unused. */
+    uint32_t  allocs;
+    uint32_t  used;
+    uint32_t  peak;
+} mem_stats_site_t;
+
+typedef struct {
+    uint16_t id;                        /**< Application defined, e.g. a scheduler event id. */
+    uint16_t count;                     /**< Number of times the phase was entered. */
+    uint32_t stack_peak;
+    uint32_t heap_peak;
+} mem_stats_phase_t;
+
+#if (MEM_STATS_ENABLED == 1)
+
+/**@brief Function for painting the unused stack. Call first thing in main(). */
+void mem_stats_init(void);
+
+/**@brief Function for accounting a block returned by the allocator, NULL for a failed request.
+ *
+ * @param[in] site  Return address of the allocation call.
+ */
+void mem_stats_on_alloc(void const * p, size_t size, uintptr_t site);
+
+/**@brief Function for accounting a block about to be released by the allocator. */
+void mem_stats_on_free(void const * p);
+
+/**@brief Function for sampling the stack high water mark and reading the totals. */
+void mem_stats_get(mem_stats_t * p_stats);
+
+/**@brief Function for getting a heap call site record, NULL past the last one in use. */
+mem_stats_site_t const * mem_stats_site_get(uint32_t idx);
+
+/**@brief Function for ending the current phase and starting phase @p id.
+ *
+ * @note Main loop or SoftDevice event context only, the stack is repainted. The phase table is
+ *       updated in a critical region, so the two contexts may mark concurrently.
+ */
+void mem_stats_phase_mark(uint16_t id);
+
+/**@brief Function for getting a phase record, NULL past the last one in use. */
+mem_stats_phase_t const * mem_stats_phase_get(uint32_t idx);
+
+#else
+
+static inline void mem_stats_init(void)
+{
+}
+
+static inline void mem_stats_on_alloc(void const * p, size_t size, uintptr_t site)
+{
+}
+
+static inline void mem_stats_on_free(void const * p)
+{
+}
+
+static inline void mem_stats_get(mem_stats_t * p_stats)
+{
+    memset(p_stats, 0, sizeof(mem_stats_t));
+}
+
+static inline mem_stats_site_t const * mem_stats_site_get(uint32_t idx)
+{
+    return NULL;
+}
+
+static inline void mem_stats_phase_mark(uint16_t id)
+{
+}
+
+static inline mem_stats_phase_t const * mem_stats_phase_get(uint32_t idx)
+{
+    return NULL;
+}
+
+#endif // MEM_STATS_ENABLED
+
+#endif // MEM_STATS_H__
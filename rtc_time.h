@@ -0,0 +1,41 @@
+/**@file
+ *
+ * @brief Wall clock on top of RTC1, see time.c.
+ */
+#ifndef RTC_TIME_H__
+#define RTC_TIME_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define TIME_ISO8601_LEN                21                                      /**< "YYYY-MM-DDThh:mm:ssZ" including the terminating NUL. */
+
+/**@brief Function for setting the wall clock.
+ *
+ * @details Successive phone syncs at least 48 h apart are used to learn the 32 kHz clock
+ *          drift, which is then corrected continuously. Measurements are averaged weighted by
+ *          their interval; those beyond the LF clock accuracy and stepped corrections are not
+ *          used. Errors up to 60 s are slewed at 2 ms/s instead of stepped, so time() never
+ *          goes backwards for them.
+ *
+ * @param[in] time_ptr  UTC time, or NULL to start from the firmware build time.
+ */
+void time_init(struct tm * time_ptr);
+
+/**@brief Function for getting the learned clock drift in parts per billion. */
+int32_t time_drift_ppb_get(void);
+
+/**@brief Function for formatting a Unix time as ISO-8601 UTC without libc gmtime()/strftime().
+ *
+ * @details The date part is cached and only reformatted when the day changes.
+ *          Not reentrant, call from one context only.
+ *
+ * @return Number of characters written, excluding the NUL, or 0 if @p len is too small.
+ */
+size_t time_iso8601(time_t utc_time, char * buf, size_t len);
+
+/**@brief Timestamp function for nrf_log: milliseconds of the current UTC day. */
+uint32_t time_log_timestamp(void);
+
+#endif // RTC_TIME_H__
@@ -0,0 +1,186 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nordic_common.h"
+#include "app_util.h"
+#include "app_util_platform.h"
+#include "session_arena.h"
+
+#if (SESSION_ARENA_ENABLED == 1)
+
+#define ARENA_ALIGN                 8
+#define GEN_FREE                    0           /* Generation of a released block. */
+
+typedef struct {
+    uint32_t gen;                               /* Session the block was allocated in. */
+    uint32_t size;                              /* Requested size. */
+} block_hdr_t;
+
+STATIC_ASSERT(SESSION_ARENA_SIZE % ARENA_ALIGN == 0);
+STATIC_ASSERT(sizeof(block_hdr_t) == ARENA_ALIGN);
+
+static uint64_t m_arena[SESSION_ARENA_SIZE / sizeof(uint64_t)];
+static uint32_t m_offset;
+static uint32_t m_high;                         /* Highest offset since the last clear, all of it is cleared. */
+static uint32_t m_live;                         /* Live blocks, all of generation m_gen. */
+static uint32_t m_gen;
+static bool     m_open;
+
+static session_arena_stats_t m_stats;
+
+/* Caller holds the critical region and has checked that no block is live. */
+static void arena_clear(void)
+{
+    /* Certificates, ECDH scratch and derived keys must not outlive the session. */
+    memset(m_arena, 0, m_high);
+    m_offset = 0;
+    m_high   = 0;
+}
+
+static block_hdr_t * block_hdr(void const * p)
+{
+    uint8_t const * p_byte = p;
+
+    if (p_byte < (uint8_t const *)m_arena + sizeof(block_hdr_t) ||
+        p_byte >= (uint8_t const *)m_arena + SESSION_ARENA_SIZE)
+        return NULL;
+    return (block_hdr_t *)(p_byte - sizeof(block_hdr_t));
+}
+
+ret_code_t session_arena_begin(void)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+
+    CRITICAL_REGION_ENTER();
+    if (m_open) {
+        err_code = NRF_ERROR_INVALID_STATE;
+    } else if (m_live != 0) {
+        err_code = NRF_ERROR_BUSY;
+    } else {
+        m_gen = (m_gen + 1 == GEN_FREE) ? m_gen + 2 : m_gen + 1;
+        m_open = true;
+        m_stats.sessions++;
+    }
+    CRITICAL_REGION_EXIT();
+
+    return err_code;
+}
+
+ret_code_t session_arena_end(void)
+{
+    ret_code_t err_code = NRF_SUCCESS;
+
+    CRITICAL_REGION_ENTER();
+    if (m_open) {
+        m_open = false;
+        m_stats.last_peak = m_high;
+        m_stats.peak      = MAX(m_stats.peak, m_high);
+        if (m_live == 0) {
+            arena_clear();
+        } else {
+            /* Still in use, e.g. derived keys: cleared by the last free() instead. */
+            m_stats.busy++;
+            err_code = NRF_ERROR_BUSY;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    return err_code;
+}
+
+uint32_t session_arena_reset(void)
+{
+    uint32_t dropped;
+
+    (void)session_arena_end();
+
+    CRITICAL_REGION_ENTER();
+    dropped = m_live;
+    if (dropped != 0) {
+        /* A new generation turns any later free() of the dropped blocks into a stale one. */
+        m_gen  = (m_gen + 1 == GEN_FREE) ? m_gen + 2 : m_gen + 1;
+        m_live = 0;
+        arena_clear();
+        m_stats.resets++;
+        m_stats.dropped += dropped;
+    }
+    CRITICAL_REGION_EXIT();
+
+    return dropped;
+}
+
+void * session_arena_alloc(size_t size)
+{
+    block_hdr_t * p_hdr = NULL;
+    size_t        total;
+
+    if (size == 0 || size > SESSION_ARENA_SIZE)
+        return NULL;
+    total = sizeof(block_hdr_t) + ALIGN_NUM(ARENA_ALIGN, size);
+
+    CRITICAL_REGION_ENTER();
+    if (m_open) {
+        if (total <= SESSION_ARENA_SIZE - m_offset) {
+            p_hdr       = (block_hdr_t *)((uint8_t *)m_arena + m_offset);
+            p_hdr->gen  = m_gen;
+            p_hdr->size = size;
+            m_offset   += total;
+            m_high      = MAX(m_high, m_offset);
+            m_live++;
+        } else {
+            m_stats.overflows++;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    return p_hdr == NULL ? NULL : p_hdr + 1;
+}
+
+bool session_arena_free(void * p)
+{
+    block_hdr_t * p_hdr = block_hdr(p);
+
+    if (p_hdr == NULL)
+        return false;
+
+    CRITICAL_REGION_ENTER();
+    if (m_live == 0 || p_hdr->gen != m_gen) {
+        m_stats.stale_frees++;
+    } else {
+        p_hdr->gen = GEN_FREE;
+        m_live--;
+        /* The last block gives its space back: scratch buffers are reused within a running
+         * session, and an ended session is cleared now. */
+        if (m_live == 0) {
+            if (m_open)
+                m_offset = 0;
+            else
+                arena_clear();
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    return true;
+}
+
+size_t session_arena_block_size(void const * p)
+{
+    block_hdr_t const * p_hdr = block_hdr(p);
+
+    if (p_hdr == NULL)
+        return 0;
+    /* Bounded by the arena for pointers that are not a block start. */
+    return MIN(p_hdr->size, (uint32_t)((uint8_t const *)m_arena + SESSION_ARENA_SIZE - (uint8_t const *)p));
+}
+
+void session_arena_stats_get(session_arena_stats_t * p_stats)
+{
+    CRITICAL_REGION_ENTER();
+    *p_stats = m_stats;
+    p_stats->peak = MAX(p_stats->peak, m_high);
+    CRITICAL_REGION_EXIT();
+}
+
+#endif // SESSION_ARENA_ENABLED
@@ -0,0 +1,100 @@
+/**@file
+ *
+ * @brief Bump allocator for the objects of one authentication session.
+ *
+ * @details Between session_arena_begin() and session_arena_end() the allocator wrappers in
+ *          mem_pool.c serve requests from a static arena by advancing a pointer. The application
+ *          brackets the auth steps only, so later allocations of the connection, e.g. for
+ *          mibeacon objects, go to the pools or the heap. free() of arena blocks only updates
+ *          the live block count. Ending the session clears the used part of the arena so no key
+ *          material survives, and records the peak use.
+ *
+ *          The arena never takes back a block that is still live while the connection is up. If
+ *          blocks are live when the session ends, session_arena_end() reports it, new requests are
+ *          no longer served and the arena is cleared once the last of them is freed. Every block
+ *          carries the generation of its session, free() of a block that does not belong to the
+ *          current session, e.g. a double free, is ignored and counted.
+ *
+ *          Blocks still live after the library has torn the connection down are leaks and would
+ *          keep the arena from ever serving another session. The application calls
+ *          session_arena_reset() from the main loop after a disconnect: it drops such blocks,
+ *          counts the reset and clears the arena. A later free() of a dropped block is stale.
+ *
+ *          Enabled by default on the nRF52832 and nRF52840, the nRF52810 has no RAM to spare.
+ */
+#ifndef SESSION_ARENA_H__
+#define SESSION_ARENA_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdk_errors.h"
+
+#ifndef SESSION_ARENA_ENABLED
+#if defined(NRF52810_XXAA)
+#define SESSION_ARENA_ENABLED           0
+#else
+#define SESSION_ARENA_ENABLED           1
+#endif
+#endif
+
+#ifndef SESSION_ARENA_SIZE
+#if defined(NRF52810_XXAA)
+#define SESSION_ARENA_SIZE              1024
+#else
+#define SESSION_ARENA_SIZE              2048
+#endif
+#endif
+
+typedef struct {
+    uint32_t sessions;
+    uint32_t peak;                      /**< Largest arena use of any session, in bytes, incl. block headers. */
+    uint32_t last_peak;                 /**< Arena use of the last ended session. */
+    uint32_t overflows;                 /**< Requests that did not fit and went to the pools or the heap. */
+    uint32_t busy;                      /**< Sessions that ended with live blocks. */
+    uint32_t stale_frees;               /**< free() calls for blocks not live in the current session. */
+    uint32_t resets;                    /**< Resets that dropped leaked blocks. */
+    uint32_t dropped;                   /**< Leaked blocks dropped by the resets. */
+} session_arena_stats_t;
+
+/**@brief Function for beginning a session, e.g. when auth starts.
+ *
+ * @retval NRF_SUCCESS              Requests are served from the arena until session_arena_end().
+ * @retval NRF_ERROR_INVALID_STATE  A session is already running.
+ * @retval NRF_ERROR_BUSY           Blocks of an ended session are still live.
+ */
+ret_code_t session_arena_begin(void);
+
+/**@brief Function for ending the session. Nothing happens if none is running.
+ *
+ * @retval NRF_SUCCESS     The arena was cleared.
+ * @retval NRF_ERROR_BUSY  Blocks are still live. They stay valid, the arena is cleared once the
+ *                         last one is freed.
+ */
+ret_code_t session_arena_end(void);
+
+/**@brief Function for ending the session and dropping any block that is still live.
+ *
+ * @details Only for the point where the owner of the blocks is known to be done with them, e.g.
+ *          after the library has handled a disconnect.
+ *
+ * @return Number of blocks dropped, 0 if the arena was idle or cleared normally.
+ */
+uint32_t session_arena_reset(void);
+
+/**@brief Function for allocating from the running session, NULL if none is running or full. */
+void * session_arena_alloc(size_t size);
+
+/**@brief Function for releasing an arena block.
+ *
+ * @retval false  @p p is not in the arena.
+ */
+bool session_arena_free(void * p);
+
+/**@brief Function for getting the requested size of an arena block, 0 if @p p is not in the arena. */
+size_t session_arena_block_size(void const * p);
+
+/**@brief Function for reading the statistics. */
+void session_arena_stats_get(session_arena_stats_t * p_stats);
+
+#endif // SESSION_ARENA_H__
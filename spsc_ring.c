@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "nrf.h"
+#include "spsc_ring.h"
+
+/* Copies between linear memory and the ring, splitting the access at the end of the buffer. */
+static void ring_write(spsc_ring_t * p_ring, uint32_t idx, const uint8_t * p_src, uint32_t len)
+{
+    if (len == 0)
+        return;
+
+    uint32_t off   = idx & p_ring->mask;
+    uint32_t first = MIN(len, p_ring->mask + 1 - off);
+
+    memcpy(p_ring->p_buf + off, p_src, first);
+    memcpy(p_ring->p_buf, p_src + first, len - first);
+}
+
+static void ring_read(spsc_ring_t const * p_ring, uint32_t idx, uint8_t * p_dst, uint32_t len)
+{
+    uint32_t off   = idx & p_ring->mask;
+    uint32_t first = MIN(len, p_ring->mask + 1 - off);
+
+    memcpy(p_dst, p_ring->p_buf + off, first);
+    memcpy(p_dst + first, p_ring->p_buf, len - first);
+}
+
+ret_code_t spsc_ring_push2(spsc_ring_t * p_ring, const void * p_data1, uint32_t len1,
+                           const void * p_data2, uint32_t len2)
+{
+    uint32_t head = p_ring->head;
+    uint32_t tail = p_ring->tail;
+    uint32_t space = p_ring->mask + 1 - (head - tail);
+
+    if (len1 > space || len2 > space - len1)
+        return NRF_ERROR_NO_MEM;
+
+    ring_write(p_ring, head, p_data1, len1);
+    ring_write(p_ring, head + len1, p_data2, len2);
+    /* The data must be in place before the consumer can see the new head. */
+    __DMB();
+    (void)nrf_atomic_u32_store(&p_ring->head, head + len1 + len2);
+
+    return NRF_SUCCESS;
+}
+
+ret_code_t spsc_ring_push(spsc_ring_t * p_ring, const void * p_data, uint32_t len)
+{
+    return spsc_ring_push2(p_ring, p_data, len, NULL, 0);
+}
+
+uint32_t spsc_ring_pop(spsc_ring_t * p_ring, void * p_data, uint32_t len)
+{
+    uint32_t tail = p_ring->tail;
+    uint32_t head = p_ring->head;
+
+    len = MIN(len, head - tail);
+    if (len == 0)
+        return 0;
+
+    /* Read the data only after the head that covers it. */
+    __DMB();
+    ring_read(p_ring, tail, p_data, len);
+    /* Release the space only after the data has been copied out. */
+    __DMB();
+    (void)nrf_atomic_u32_store(&p_ring->tail, tail + len);
+
+    return len;
+}
+
+uint32_t spsc_ring_used(spsc_ring_t const * p_ring)
+{
+    return p_ring->head - p_ring->tail;
+}
@@ -0,0 +1,68 @@
+/**@file
+ *
+ * @brief Lock-free single producer, single consumer byte ring.
+ *
+ * @details The producer only writes the head index and the consumer only writes the tail index,
+ *          so one interrupt handler can feed the main loop without critical sections. Both
+ *          indices run freely and are masked on access, which requires a power of two size and
+ *          lets the ring use all of its bytes. Data is copied in bulk with at most two memcpy()
+ *          calls per buffer.
+ *
+ *          tools/host/spsc_ring_test.c stress tests the ring with a producer and a consumer
+ *          thread on the host, see the file for the build line.
+ *
+ * @note Each ring must have exactly one producer context and one consumer context.
+ */
+#ifndef SPSC_RING_H__
+#define SPSC_RING_H__
+
+#include <stdint.h>
+#include "nordic_common.h"
+#include "nrf_atomic.h"
+#include "sdk_errors.h"
+
+typedef struct {
+    uint8_t *        p_buf;
+    uint32_t         mask;              /**< Size - 1. */
+    nrf_atomic_u32_t head;              /**< Bytes pushed, written by the producer only. */
+    nrf_atomic_u32_t tail;              /**< Bytes popped, written by the consumer only. */
+} spsc_ring_t;
+
+/**@brief Macro for defining a ring instance.
+ *
+ * @param[in] name  Name of the instance.
+ * @param[in] size  Size in bytes, must be a power of two.
+ */
+#define SPSC_RING_DEF(name, size)                                                           \
+    STATIC_ASSERT((size) != 0 && ((size) & ((size) - 1)) == 0);                             \
+    static uint8_t     CONCAT_2(name, _buf)[size];                                          \
+    static spsc_ring_t name = { .p_buf = CONCAT_2(name, _buf), .mask = (size) - 1 }
+
+/**@brief Function for pushing @p len bytes, all or nothing. Producer only.
+ *
+ * @retval NRF_SUCCESS       The bytes are visible to the consumer.
+ * @retval NRF_ERROR_NO_MEM  Not enough free space, nothing was pushed.
+ */
+ret_code_t spsc_ring_push(spsc_ring_t * p_ring, const void * p_data, uint32_t len);
+
+/**@brief Function for pushing two buffers as one unit, e.g. a frame header and its payload.
+ *
+ * @details Both parts are written before the head is published, so the consumer sees either
+ *          nothing or both, and the producer needs no staging copy. Producer only.
+ *
+ * @retval NRF_SUCCESS       The bytes are visible to the consumer.
+ * @retval NRF_ERROR_NO_MEM  Not enough free space for both parts, nothing was pushed.
+ */
+ret_code_t spsc_ring_push2(spsc_ring_t * p_ring, const void * p_data1, uint32_t len1,
+                           const void * p_data2, uint32_t len2);
+
+/**@brief Function for popping up to @p len bytes. Consumer only.
+ *
+ * @return Number of bytes popped.
+ */
+uint32_t spsc_ring_pop(spsc_ring_t * p_ring, void * p_data, uint32_t len);
+
+/**@brief Function for getting the number of bytes ready to be popped. */
+uint32_t spsc_ring_used(spsc_ring_t const * p_ring);
+
+#endif // SPSC_RING_H__
@@ -1,17 +1,72 @@
 #include <time.h>
+#include <stdbool.h>
 #include <string.h>
+#include "nordic_common.h"
 #include "nrf_rtc.h"
+#include "app_util_platform.h"
+#include "rtc_time.h"
 
 #pragma import(__use_no_semihosting)
 
+/* Days since 1970-01-01 of a proleptic Gregorian date, valid for years >= 1 (H. Hinnant). */
+#define CIVIL_YEAR(y, m)            ((y) - ((m) <= 2))
+#define CIVIL_DOY(m, d)             ((153 * ((m) > 2 ? (m) - 3 : (m) + 9) + 2) / 5 + (d) - 1)
+#define CIVIL_DOE(y, doy)           ((y) % 400 * 365 + (y) % 400 / 4 - (y) % 400 / 100 + (doy))
+#define DAYS_FROM_CIVIL(y, m, d)    (CIVIL_YEAR(y, m) / 400 * 146097L +                         \
+                                     CIVIL_DOE(CIVIL_YEAR(y, m), CIVIL_DOY(m, d)) - 719468L)
+
+/* __DATE__ is "Mmm dd yyyy", __TIME__ is "hh:mm:ss". Both fold to constants at compile time. */
+#define DIGIT(c)                    ((c) - '0')
+#define BUILD_YEAR                  (DIGIT(__DATE__[7]) * 1000 + DIGIT(__DATE__[8]) * 100 +     \
+                                     DIGIT(__DATE__[9]) * 10 + DIGIT(__DATE__[10]))
+#define BUILD_MONTH                 (__DATE__[0] == 'J' ? (__DATE__[1] == 'a' ? 1 :             \
+                                                           __DATE__[2] == 'n' ? 6 : 7) :        \
+                                     __DATE__[0] == 'F' ? 2 :                                   \
+                                     __DATE__[0] == 'M' ? (__DATE__[2] == 'r' ? 3 : 5) :        \
+                                     __DATE__[0] == 'A' ? (__DATE__[1] == 'p' ? 4 : 8) :        \
+                                     __DATE__[0] == 'S' ? 9 :                                   \
+                                     __DATE__[0] == 'O' ? 10 :                                  \
+                                     __DATE__[0] == 'N' ? 11 : 12)
+#define BUILD_DAY                   ((__DATE__[4] == ' ' ? 0 : DIGIT(__DATE__[4]) * 10) +       \
+                                     DIGIT(__DATE__[5]))
+#define BUILD_SEC_OF_DAY            ((DIGIT(__TIME__[0]) * 10 + DIGIT(__TIME__[1])) * 3600L +   \
+                                     (DIGIT(__TIME__[3]) * 10 + DIGIT(__TIME__[4])) * 60 +      \
+                                     DIGIT(__TIME__[6]) * 10 + DIGIT(__TIME__[7]))
+#define BUILD_EPOCH_LOCAL           (DAYS_FROM_CIVIL(BUILD_YEAR, BUILD_MONTH, BUILD_DAY) * 86400L + \
+                                     BUILD_SEC_OF_DAY)
+
+#ifndef COMPILED_TIME_ZONE_OFFSET
+#define COMPILED_TIME_ZONE_OFFSET   (8 * 3600)    /* compiled time is UTC+8 */
+#endif
+
+#define TICKS_PER_SEC               32768
+#define SLEW_MAX_SEC                60            /* Larger corrections are stepped. */
+#define SLEW_RATE_PPM               2000          /* 2 ms/s, a 60 s error is absorbed in 8.3 h. */
+#define DRIFT_MIN_INTERVAL_SEC      (48 * 3600)   /* 1 s sync resolution at both ends gives < 12 ppm error. */
+#define DRIFT_MAX_WEIGHT_SEC        (30 * 86400)  /* Older history fades, crystal aging and temperature change. */
+#define DRIFT_RESOLUTION_PPB(sec)   (2000000000LL / (sec))
+
+#ifndef DRIFT_LF_ACCURACY_PPB
+#define DRIFT_LF_ACCURACY_PPB       20000         /* NRF_SDH_CLOCK_LF_ACCURACY 7, 20 ppm crystal. */
+#endif
+
 extern volatile uint32_t rtc1_overflow_cnt;
 
 static uint32_t ticks_per_cnt = 1;
-static time_t offset_time_in_sec;             /* Time passed since Unix epoch */
-static const char * _month[] =  {  
-    "Jan", "Feb", "Mar", "Apr", "May", "Jun",
-    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec",
-};
+
+/* UTC(raw) = base_utc + elapsed * (1 + drift) + slew, with elapsed = raw - base_raw. */
+static int64_t  base_utc;                     /* UTC in ticks at base_raw */
+static uint64_t base_raw;
+static int64_t  slew_ticks;                   /* Correction absorbed at SLEW_RATE_PPM from base_raw */
+static int32_t  drift_ppb;                    /* Local clock error, positive when it runs slow */
+static uint32_t drift_weight = DRIFT_MIN_INTERVAL_SEC;  /* Seconds of measurement behind drift_ppb, starts as a prior at 0 */
+
+/* Last phone sync, the reference for the next drift measurement. */
+static bool     anchor_valid;
+static int64_t  anchor_utc;
+static uint64_t anchor_raw;
+
+static volatile time_t last_seconds;          /* Keeps time() monotonic across slewed corrections */
 
 clock_t clock(void)
 {
@@ -19,19 +74,57 @@ clock_t clock(void)
     return nrf_rtc_counter_get(NRF_RTC1);
 }
 
-time_t time(time_t *p_time)
+/* 32768 Hz ticks since RTC1 started. */
+static uint64_t rtc_ticks(void)
 {
-    time_t seconds;
+    uint32_t overflows;
+    uint32_t counter;
 
+    /* Also called from interrupts through the log timestamp. Check, clear and count must be one
+     * step, a caller preempting in between would count the same overflow twice. */
+    CRITICAL_REGION_ENTER();
+    counter = nrf_rtc_counter_get(NRF_RTC1);
     if(nrf_rtc_event_pending(NRF_RTC1, NRF_RTC_EVENT_OVERFLOW))
-    {  
+    {
         nrf_rtc_event_clear(NRF_RTC1, NRF_RTC_EVENT_OVERFLOW);
+        /* Read back so the clear has landed before the next caller checks the event. */
+        (void)nrf_rtc_event_pending(NRF_RTC1, NRF_RTC_EVENT_OVERFLOW);
         rtc1_overflow_cnt++;
+        /* The counter may have been read just before it wrapped. */
+        counter = nrf_rtc_counter_get(NRF_RTC1);
     }
+    overflows = rtc1_overflow_cnt;
+    CRITICAL_REGION_EXIT();
+
+    /* ticks = (rtc1_overflow_cnt * 2^24 + RTC_COUNT) * TICKS_PER_CNT */
+    return (((uint64_t)overflows << 24) + counter) * ticks_per_cnt;
+}
+
+/* Drift and slew corrected UTC in ticks. */
+static int64_t utc_ticks(uint64_t raw)
+{
+    int64_t elapsed = (int64_t)(raw - base_raw);
+    int64_t slew    = elapsed * SLEW_RATE_PPM / 1000000;
+    int64_t pending = slew_ticks < 0 ? -slew_ticks : slew_ticks;
+
+    if (slew > pending)
+        slew = pending;
+
+    return base_utc + elapsed + elapsed * drift_ppb / 1000000000 + (slew_ticks < 0 ? -slew : slew);
+}
+
+time_t time(time_t *p_time)
+{
+    time_t seconds;
+
+    /* seconds = ticks / 32768 */
+    seconds = utc_ticks(rtc_ticks()) >> 15;
 
-    /* seconds = (rtc1_overflow_cnt * 2^24 + RTC_COUNT) * TICKS_PER_CNT / 32768 */
-    seconds = ((rtc1_overflow_cnt<<24) + nrf_rtc_counter_get(NRF_RTC1)) * ticks_per_cnt >> 15;
-    seconds += offset_time_in_sec;
+    /* Rounding while a negative slew starts must not repeat a second. */
+    if (seconds < last_seconds)
+        seconds = last_seconds;
+    else
+        last_seconds = seconds;
 
     if ( p_time != NULL )
         *p_time = seconds;
@@ -39,13 +132,14 @@ time_t time(time_t *p_time)
     return seconds;
 }
 
-static int month2int( char * str )
+/* UTC broken down time to Unix time, without the libc mktime() and its time zone handling. */
+static time_t tm2time(struct tm const * p_tm)
 {
-    int i;
-    for (i = 0; i < 12; i++)
-        if (strcmp(_month[i], str) == 0)
-            break;
-    return i;
+    int32_t year  = p_tm->tm_year + 1900;
+    int32_t month = p_tm->tm_mon + 1;
+
+    return DAYS_FROM_CIVIL(year, month, p_tm->tm_mday) * 86400L +
+           p_tm->tm_hour * 3600L + p_tm->tm_min * 60 + p_tm->tm_sec;
 }
 
 void set_time_rtc_prescaler(uint32_t pre)
@@ -53,25 +147,149 @@ void set_time_rtc_prescaler(uint32_t pre)
     ticks_per_cnt = pre + 1;
 }
 
+/* Starts a new drift measurement at a phone sync. */
+static void drift_anchor(int64_t phone, uint64_t raw)
+{
+    anchor_valid = true;
+    anchor_utc   = phone;
+    anchor_raw   = raw;
+}
+
+/* Learns the oscillator error from the phone time elapsed since the previous sync. Measurements
+ * are averaged weighted by their interval, as the sync resolution error shrinks with it. */
+static void drift_update(int64_t phone, uint64_t raw)
+{
+    if (!anchor_valid) {
+        drift_anchor(phone, raw);
+        return;
+    }
+
+    int64_t local = (int64_t)(raw - anchor_raw);
+    if (local < (int64_t)DRIFT_MIN_INTERVAL_SEC * TICKS_PER_SEC)
+        return;
+
+    uint32_t local_sec = (uint32_t)(local / TICKS_PER_SEC);
+    int64_t  meas      = ((phone - anchor_utc) - local) * 1000000000 / local;
+
+    /* More than the crystal can be off is a phone clock change, not drift. The old anchor may be
+     * the wrong one, so measure from this sync on. */
+    if (meas > DRIFT_LF_ACCURACY_PPB + DRIFT_RESOLUTION_PPB(local_sec) ||
+        meas < -(DRIFT_LF_ACCURACY_PPB + DRIFT_RESOLUTION_PPB(local_sec))) {
+        drift_anchor(phone, raw);
+        return;
+    }
+
+    drift_ppb   += (int32_t)((meas - drift_ppb) * local_sec / ((int64_t)drift_weight + local_sec));
+    drift_weight = MIN(drift_weight + local_sec, DRIFT_MAX_WEIGHT_SEC);
+
+    drift_anchor(phone, raw);
+}
+
 void time_init(struct tm * time_ptr) 
 {
+    CRITICAL_REGION_ENTER();
+    uint64_t raw = rtc_ticks();
+
     if ( time_ptr == NULL ) {
         /* Use Compiled time as system init time. */
-        char month_name[5];
-        struct tm compiled_tm = {0};
-        sscanf(__DATE__, "%s %d %d", month_name, &compiled_tm.tm_mday, &compiled_tm.tm_year);
-        sscanf(__TIME__, "%d:%d:%d", &compiled_tm.tm_hour, &compiled_tm.tm_min, &compiled_tm.tm_sec);
-        
-        compiled_tm.tm_mon = month2int(month_name);
-        compiled_tm.tm_year -= 1900;
-        
-        offset_time_in_sec = mktime(&compiled_tm) - 8 * 3600;  // compiled time is UTC+8
+        base_utc     = (int64_t)(BUILD_EPOCH_LOCAL - COMPILED_TIME_ZONE_OFFSET) * TICKS_PER_SEC;
+        slew_ticks   = 0;
+        anchor_valid = false;
+        last_seconds = 0;
     } else {
-        time_t current_time = time(NULL);
-        time_t new_time     = mktime(time_ptr);
-        if ( new_time > current_time )
-            offset_time_in_sec += new_time - current_time;
-        else
-            offset_time_in_sec -= current_time - new_time;
+        int64_t phone = (int64_t)tm2time(time_ptr) * TICKS_PER_SEC;
+        int64_t now   = utc_ticks(raw);
+        int64_t error = phone - now;
+
+        if (error > (int64_t)SLEW_MAX_SEC * TICKS_PER_SEC || error < -(int64_t)SLEW_MAX_SEC * TICKS_PER_SEC) {
+            /* Too far off to slew, e.g. the build time fallback. Monotonicity restarts here.
+             * No drift explains such an error, only measure from this sync on. */
+            drift_anchor(phone, raw);
+            base_utc     = phone;
+            slew_ticks   = 0;
+            last_seconds = 0;
+        } else {
+            /* Continue from the current reading and absorb the error gradually. */
+            drift_update(phone, raw);
+            base_utc   = now;
+            slew_ticks = error;
+        }
     }
+
+    base_raw = raw;
+    CRITICAL_REGION_EXIT();
+}
+
+int32_t time_drift_ppb_get(void)
+{
+    return drift_ppb;
+}
+
+
+/* Unix day number to proleptic Gregorian date, inverse of DAYS_FROM_CIVIL (H. Hinnant). */
+static void civil_from_days(int32_t z, int32_t * p_year, uint32_t * p_month, uint32_t * p_day)
+{
+    z += 719468;
+    int32_t  era = (z >= 0 ? z : z - 146096) / 146097;
+    uint32_t doe = (uint32_t)(z - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp  = (5 * doy + 2) / 153;
+
+    *p_day   = doy - (153 * mp + 2) / 5 + 1;
+    *p_month = mp < 10 ? mp + 3 : mp - 9;
+    *p_year  = (int32_t)yoe + era * 400 + (*p_month <= 2);
+}
+
+static void put_2digits(char * p, uint32_t val)
+{
+    p[0] = '0' + val / 10;
+    p[1] = '0' + val % 10;
+}
+
+/* "YYYY-MM-DDT" of the last formatted day, only rebuilt when the day changes. */
+static int32_t cached_day = -1;
+static char    cached_date[11];
+
+size_t time_iso8601(time_t utc_time, char * buf, size_t len)
+{
+    int32_t  day = utc_time / 86400;
+    uint32_t sec = utc_time % 86400;
+
+    if (buf == NULL || len < TIME_ISO8601_LEN)
+        return 0;
+
+    if (day != cached_day) {
+        int32_t  year;
+        uint32_t month, mday;
+        civil_from_days(day, &year, &month, &mday);
+        put_2digits(cached_date, year / 100);
+        put_2digits(cached_date + 2, year % 100);
+        cached_date[4] = '-';
+        put_2digits(cached_date + 5, month);
+        cached_date[7] = '-';
+        put_2digits(cached_date + 8, mday);
+        cached_date[10] = 'T';
+        cached_day = day;
+    }
+
+    memcpy(buf, cached_date, sizeof(cached_date));
+    put_2digits(buf + 11, sec / 3600);
+    buf[13] = ':';
+    put_2digits(buf + 14, sec / 60 % 60);
+    buf[16] = ':';
+    put_2digits(buf + 17, sec % 60);
+    buf[19] = 'Z';
+    buf[20] = '\0';
+
+    return TIME_ISO8601_LEN - 1;
+}
+
+uint32_t time_log_timestamp(void)
+{
+    int64_t  ticks   = utc_ticks(rtc_ticks());
+    uint32_t seconds = (uint32_t)(ticks >> 15);
+
+    /* Milliseconds of the UTC day, nrf_log renders them as hh:mm:ss.ms */
+    return seconds % 86400 * 1000 + (((uint32_t)ticks & 0x7FFF) * 1000 >> 15);
 }
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Decode bin_log records captured from the RTT channel into text.
+
+Usage:
+    JLinkRTTLogger -Device NRF52832_XXAA -If SWD -Speed 4000 -RTTChannel 1 bin_log.raw
+    bin_log_decode.py firmware.axf bin_log.raw
+
+The format strings are read from the bin_log_fmt section of the ELF image the
+target was flashed with. armlink names output sections after the execution
+region (ER_IROM1), so the section is located through its linker defined start
+symbol, as NRF_SECTION_START_ADDR() does on the target: bin_log_fmt$$Base with
+armcc, __start_bin_log_fmt with GCC. %s arguments carry the string itself, cut
+at BIN_LOG_STR_MAX characters on the target.
+"""
+import argparse
+import re
+import struct
+import sys
+
+RTC_FREQ = 32768
+LEVELS = {1: 'E', 2: 'W', 3: 'I', 4: 'D'}
+LEVEL_HEXDUMP = 15
+HDR_LEN = 6
+
+SHF_ALLOC = 0x2
+SHT_PROGBITS = 1
+SHT_SYMTAB = 2
+
+FMT_BASE_SYMBOLS = ('bin_log_fmt$$Base', '__start_bin_log_fmt')
+
+
+class Elf32(object):
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1:
+            raise ValueError('%s is not a 32-bit ELF file' % path)
+        (shoff,) = struct.unpack_from('<I', self.data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', self.data, 0x2E)
+        hdrs = [struct.unpack_from('<IIIIIIIIII', self.data, shoff + i * shentsize)
+                for i in range(shnum)]
+        strtab = hdrs[shstrndx]
+        self.sections = []
+        for h in hdrs:
+            name_off = strtab[4] + h[0]
+            name = self.data[name_off:self.data.index(b'\0', name_off)].decode()
+            self.sections.append({'name': name, 'type': h[1], 'flags': h[2],
+                                  'addr': h[3], 'offset': h[4], 'size': h[5],
+                                  'link': h[6], 'entsize': h[9]})
+        self.symbols = {}
+        for s in self.sections:
+            if s['type'] == SHT_SYMTAB:
+                self._read_symtab(s, self.sections[s['link']])
+
+    def _read_symtab(self, symtab, strtab):
+        entsize = symtab['entsize'] or 16
+        for off in range(symtab['offset'], symtab['offset'] + symtab['size'], entsize):
+            name_off, value = struct.unpack_from('<II', self.data, off)
+            if name_off == 0:
+                continue
+            start = strtab['offset'] + name_off
+            name = self.data[start:self.data.index(b'\0', start)].decode('utf-8', 'replace')
+            self.symbols.setdefault(name, value)
+
+    def symbol(self, *names):
+        for name in names:
+            if name in self.symbols:
+                return self.symbols[name]
+        return None
+
+    def section(self, *names):
+        for s in self.sections:
+            if s['name'] in names:
+                return self.data[s['offset']:s['offset'] + s['size']]
+        return None
+
+    def cstring_at(self, addr):
+        for s in self.sections:
+            if (s['flags'] & SHF_ALLOC and s['type'] == SHT_PROGBITS
+                    and s['addr'] <= addr < s['addr'] + s['size']):
+                start = s['offset'] + addr - s['addr']
+                end = self.data.find(b'\0', start, s['offset'] + s['size'])
+                return self.data[start:end].decode('utf-8', 'replace')
+        return None
+
+
+def cstring(blob, offset):
+    end = blob.find(b'\0', offset)
+    return blob[offset:end if end >= 0 else len(blob)].decode('utf-8', 'replace')
+
+
+CONV = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcsp%])')
+
+
+def read_args(fmt, argc, stream, pos):
+    """Returns the argc arguments of fmt at pos and the offset past them."""
+    convs = [m.group(5) for m in CONV.finditer(fmt) if m.group(5) != '%']
+    args = []
+    for i in range(argc):
+        if i < len(convs) and convs[i] == 's':
+            if pos >= len(stream) or pos + 1 + stream[pos] > len(stream):
+                return None, pos
+            n = stream[pos]
+            args.append(stream[pos + 1:pos + 1 + n].decode('utf-8', 'replace'))
+            pos += 1 + n
+        else:
+            if pos + 4 > len(stream):
+                return None, pos
+            args.append(struct.unpack_from('<I', stream, pos)[0])
+            pos += 4
+    return args, pos
+
+
+def render(fmt, args):
+    args = list(args)
+    out = []
+    pos = 0
+    for m in CONV.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, _, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        val = args.pop(0) if args else 0
+        spec = '%' + (flags or '') + (width or '') + ('.' + prec if prec else '')
+        if conv in 'di':
+            out.append((spec + 'd') % (val - (1 << 32) if val & 0x80000000 else val))
+        elif conv == 's':
+            out.append((spec + 's') % (val if isinstance(val, str) else '<0x%08x>' % val))
+        elif conv == 'c':
+            out.append((spec + 'c') % chr(val & 0xFF))
+        elif conv == 'p':
+            out.append('0x%08x' % val)
+        else:
+            out.append((spec + conv.replace('u', 'd')) % val)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def fmt_lookup(elf):
+    """Returns a function mapping a fmt_id to its format string."""
+    base = elf.symbol(*FMT_BASE_SYMBOLS)
+    if base is not None:
+        return lambda fmt_id: elf.cstring_at(base + fmt_id) or '<fmt %d>\n' % fmt_id
+
+    # Images linked with the section kept under its own name, e.g. stripped of symbols.
+    fmts = elf.section('bin_log_fmt', '.bin_log_fmt')
+    if fmts is None:
+        raise ValueError('no %s symbol in ELF file' % ' or '.join(FMT_BASE_SYMBOLS))
+    return lambda fmt_id: cstring(fmts, fmt_id)
+
+
+def decode(elf, stream, out):
+    fmt = fmt_lookup(elf)
+
+    pos = 0
+    last_ticks = None
+    base = 0
+    while pos + HDR_LEN <= len(stream):
+        level_argc, fmt_id = struct.unpack_from('<BH', stream, pos)
+        ticks = stream[pos + 3] | stream[pos + 4] << 8 | stream[pos + 5] << 16
+        pos += HDR_LEN
+
+        # Unwrap the 24-bit RTC counter, records are in chronological order.
+        if last_ticks is not None and ticks < last_ticks:
+            base += 1 << 24
+        last_ticks = ticks
+        stamp = '[%10.4f]' % ((base + ticks) / float(RTC_FREQ))
+
+        level, argc = level_argc >> 4, level_argc & 0x0F
+        if level == LEVEL_HEXDUMP:
+            if pos >= len(stream):
+                break
+            n = stream[pos]
+            data = stream[pos + 1:pos + 1 + n]
+            pos += 1 + n
+            out.write('%s <X> %s\n' % (stamp, ' '.join('%02X' % b for b in data)))
+            continue
+
+        if level not in LEVELS:
+            raise ValueError('corrupt record at offset %d' % (pos - HDR_LEN))
+        text = fmt(fmt_id)
+        args, pos = read_args(text, argc, stream, pos)
+        if args is None:
+            raise ValueError('truncated record at offset %d' % pos)
+        text = render(text, args)
+        out.write('%s <%s> %s' % (stamp, LEVELS[level], text))
+        if not text.endswith('\n'):
+            out.write('\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('elf', help='ELF image (.axf) the target runs')
+    parser.add_argument('log', nargs='?', help='raw RTT capture, stdin if omitted')
+    opts = parser.parse_args()
+
+    elf = Elf32(opts.elf)
+    if opts.log:
+        with open(opts.log, 'rb') as f:
+            stream = f.read()
+    else:
+        stream = sys.stdin.buffer.read()
+
+    decode(elf, stream, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
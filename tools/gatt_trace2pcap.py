@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""Convert a gatt_trace dump into a pcap file readable by Wireshark.
+
+Usage:
+    JLinkRTTLogger -Device NRF52832_XXAA -If SWD -Speed 4000 -RTTChannel 2 trace.raw
+    (press BUTTON 4 on the board)
+    gatt_trace2pcap.py trace.raw trace.pcap
+
+Records are written as HCI H4 packets (LINKTYPE_BLUETOOTH_HCI_H4_WITH_PHDR) so
+Wireshark dissects writes as ATT, and connection events as HCI events. Auth
+state transitions and stdio frames become vendor specific HCI events; stdio
+frames carry their length only, the target does not keep the decrypted data.
+Payloads longer than the bytes kept on the target are marked as truncated
+captures.
+"""
+import argparse
+import struct
+import sys
+
+REC = struct.Struct('<IIBBH12s')
+RTC_FREQ = 32768
+LINKTYPE_BLUETOOTH_HCI_H4_WITH_PHDR = 201
+
+DIR_SENT, DIR_RECV = 0, 1
+H4_ACL, H4_EVT = 0x02, 0x04
+
+GATT_TRACE_CONNECT = 1
+GATT_TRACE_DISCONNECT = 2
+GATT_TRACE_WRITE = 3
+GATT_TRACE_NOTIFY = 4
+GATT_TRACE_AUTH = 5
+GATT_TRACE_STDIO_RX = 6
+
+ATT_CID = 0x0004
+ATT_WRITE_REQ = 0x12
+VENDOR_EVT = 0xFF
+
+
+def hci_evt(code, params):
+    return bytes([H4_EVT, code, len(params)]) + params
+
+
+def to_packet(rtype, handle, length, data):
+    """Returns (direction, captured bytes, original length)."""
+    kept = data[:min(length, len(data))]
+
+    if rtype == GATT_TRACE_WRITE:
+        att = struct.pack('<BH', ATT_WRITE_REQ, handle) + kept
+        att_len = 3 + length
+        l2cap = struct.pack('<HH', att_len, ATT_CID) + att
+        # Connection handle is not kept with writes, the demo only supports one link.
+        acl = struct.pack('<BHH', H4_ACL, 0x2000, 4 + att_len) + l2cap
+        return DIR_RECV, acl, len(acl) + length - len(kept)
+
+    if rtype == GATT_TRACE_CONNECT:
+        addr_type = kept[0] if kept else 0
+        addr = (kept[1:7] + bytes(6))[:6]
+        params = struct.pack('<BBHBB6sHHHB', 0x01, 0x00, handle, 0x01, addr_type,
+                             addr, 0, 0, 0, 0)
+        pkt = hci_evt(0x3E, params)
+    elif rtype == GATT_TRACE_DISCONNECT:
+        pkt = hci_evt(0x05, struct.pack('<BHB', 0x00, handle, kept[0] if kept else 0))
+    elif rtype == GATT_TRACE_NOTIFY:
+        pkt = hci_evt(0x13, struct.pack('<BHH', 1, handle, kept[0] if kept else 0))
+    elif rtype == GATT_TRACE_STDIO_RX:
+        pkt = hci_evt(VENDOR_EVT, struct.pack('<BHB', rtype, handle, length))
+    else:
+        pkt = hci_evt(VENDOR_EVT, struct.pack('<BH', rtype, handle) + kept)
+
+    return DIR_RECV, pkt, len(pkt)
+
+
+def convert(raw, out, epoch):
+    out.write(struct.pack('<IHHiIII', 0xA1B2C3D4, 2, 4, 0, 0, 65535,
+                          LINKTYPE_BLUETOOTH_HCI_H4_WITH_PHDR))
+    last_ticks = None
+    base = 0
+    count = 0
+    for off in range(0, len(raw) - REC.size + 1, REC.size):
+        seq, ticks, rtype, length, handle, data = REC.unpack_from(raw, off)
+        if seq == 0:
+            continue
+
+        if last_ticks is not None and ticks < last_ticks:
+            base += 1 << 24
+        last_ticks = ticks
+        t = epoch + (base + ticks) / float(RTC_FREQ)
+
+        direction, pkt, orig_len = to_packet(rtype, handle, length, data)
+        pkt = struct.pack('>I', direction) + pkt
+        out.write(struct.pack('<IIII', int(t), int((t % 1) * 1e6), len(pkt), orig_len + 4))
+        out.write(pkt)
+        count += 1
+    return count
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('dump', help='raw record dump from RTT')
+    parser.add_argument('pcap', help='output pcap file')
+    parser.add_argument('--epoch', type=float, default=0.0,
+                        help='UNIX time of RTC counter value 0, for absolute timestamps')
+    opts = parser.parse_args()
+
+    with open(opts.dump, 'rb') as f:
+        raw = f.read()
+    with open(opts.pcap, 'wb') as out:
+        n = convert(raw, out, opts.epoch)
+    sys.stderr.write('%d records written\n' % n)
+
+
+if __name__ == '__main__':
+    main()
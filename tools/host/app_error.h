@@ -0,0 +1,18 @@
+/* Host shim for building SDK independent modules with tools/host tests. */
+#ifndef APP_ERROR_H__
+#define APP_ERROR_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdk_errors.h"
+
+#define APP_ERROR_CHECK(err_code)                                                   \
+    do {                                                                            \
+        ret_code_t _err = (err_code);                                               \
+        if (_err != NRF_SUCCESS) {                                                  \
+            printf("%s:%d: error %u\n", __FILE__, __LINE__, (unsigned)_err);        \
+            exit(1);                                                                \
+        }                                                                           \
+    } while (0)
+
+#endif // APP_ERROR_H__
@@ -0,0 +1,32 @@
+/* Host shim for building SDK independent modules with tools/host tests. The counter and the
+ * timer functions are implemented by the test. */
+#ifndef APP_TIMER_H__
+#define APP_TIMER_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+
+#define APP_TIMER_CLOCK_FREQ            32768
+#define APP_TIMER_MIN_TIMEOUT_TICKS     5
+#define APP_TIMER_TICKS(ms)             ((uint32_t)(((uint64_t)(ms) * APP_TIMER_CLOCK_FREQ) / 1000))
+
+typedef void (*app_timer_timeout_handler_t)(void * p_context);
+typedef void * app_timer_id_t;
+
+typedef enum {
+    APP_TIMER_MODE_SINGLE_SHOT,
+    APP_TIMER_MODE_REPEATED,
+} app_timer_mode_t;
+
+#define APP_TIMER_DEF(timer_id)                                                     \
+    static void * timer_id##_data;                                                  \
+    static const app_timer_id_t timer_id = &timer_id##_data
+
+ret_code_t app_timer_create(app_timer_id_t const * p_timer_id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t timeout_handler);
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void * p_context);
+ret_code_t app_timer_stop(app_timer_id_t timer_id);
+uint32_t   app_timer_cnt_get(void);
+uint32_t   app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from);
+
+#endif // APP_TIMER_H__
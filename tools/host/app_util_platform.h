@@ -0,0 +1,9 @@
+/* Host shim for building SDK independent modules with tools/host tests. The tests using it run
+ * single threaded, critical regions are empty. */
+#ifndef APP_UTIL_PLATFORM_H__
+#define APP_UTIL_PLATFORM_H__
+
+#define CRITICAL_REGION_ENTER() {
+#define CRITICAL_REGION_EXIT()  }
+
+#endif // APP_UTIL_PLATFORM_H__
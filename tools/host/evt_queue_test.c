@@ -0,0 +1,250 @@
+/* Host test for evt_queue: dispatch order by priority and deadline, rescheduling, periodic
+ * cadence, the slack merged wakeup timer and deadlines across the 24-bit RTC wrap. The RTC
+ * counter and the wakeup timer are simulated below.
+ *
+ * Build and run from the repository root:
+ *     gcc -std=gnu11 -O2 -Wall -I tools/host -I . \
+ *         tools/host/evt_queue_test.c evt_queue.c -o evt_queue_test && ./evt_queue_test
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "app_timer.h"
+#include "evt_queue.h"
+
+#define RTC_MASK        0x00FFFFFF
+#define TICKS(ms)       APP_TIMER_TICKS(ms)
+
+static uint32_t m_cnt;
+static bool     m_timer_running;
+static uint32_t m_timer_ticks;
+
+static char     m_log[64];
+static uint32_t m_log_len;
+static uint32_t m_failures;
+
+ret_code_t app_timer_create(app_timer_id_t const * p_timer_id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t timeout_handler)
+{
+    return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void * p_context)
+{
+    m_timer_running = true;
+    m_timer_ticks   = timeout_ticks;
+    return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_stop(app_timer_id_t timer_id)
+{
+    m_timer_running = false;
+    return NRF_SUCCESS;
+}
+
+uint32_t app_timer_cnt_get(void)
+{
+    return m_cnt;
+}
+
+uint32_t app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from)
+{
+    return (ticks_to - ticks_from) & RTC_MASK;
+}
+
+static void advance(uint32_t ms)
+{
+    m_cnt = (m_cnt + TICKS(ms)) & RTC_MASK;
+}
+
+/* Each handler appends the character it is posted with. */
+static void log_handler(void * p_context)
+{
+    if (m_log_len < sizeof(m_log) - 1)
+        m_log[m_log_len++] = (char)(uintptr_t)p_context;
+}
+
+static void periodic_handler(void * p_context)
+{
+    log_handler(p_context);
+}
+
+static void check_log(const char * p_test, const char * p_expected)
+{
+    m_log[m_log_len] = '\0';
+    if (strcmp(m_log, p_expected) != 0) {
+        printf("%s: ran \"%s\", expected \"%s\"\n", p_test, m_log, p_expected);
+        m_failures++;
+    }
+    m_log_len = 0;
+}
+
+static void check(const char * p_test, bool ok)
+{
+    if (!ok) {
+        printf("%s: failed\n", p_test);
+        m_failures++;
+    }
+}
+
+static void reset(uint32_t cnt)
+{
+    m_cnt           = cnt;
+    m_timer_running = false;
+    m_log_len       = 0;
+    evt_queue_init();
+}
+
+static void test_priority_order(void)
+{
+    reset(0);
+    evt_post(log_handler, (void *)'l', EVT_PRIO_LOW);
+    evt_post(log_handler, (void *)'h', EVT_PRIO_HIGH);
+    evt_post(log_handler, (void *)'n', EVT_PRIO_NORMAL);
+    evt_queue_process();
+    check_log("priority order", "hnl");
+    check("priority order, idle timer", !m_timer_running);
+}
+
+static void test_deadline_order(void)
+{
+    reset(0);
+    evt_post_delayed(log_handler, (void *)'c', EVT_PRIO_NORMAL, 300, 0);
+    evt_post_delayed(log_handler, (void *)'a', EVT_PRIO_NORMAL, 100, 0);
+    evt_post_delayed(log_handler, (void *)'b', EVT_PRIO_NORMAL, 200, 0);
+    evt_post_delayed(log_handler, (void *)'x', EVT_PRIO_LOW, 50, 0);
+
+    evt_queue_process();
+    check_log("deadline order, nothing due", "");
+
+    /* Due at once: priority first, then earliest deadline. */
+    advance(250);
+    evt_queue_process();
+    check_log("deadline order, due", "abx");
+
+    advance(100);
+    evt_queue_process();
+    check_log("deadline order, last", "c");
+}
+
+static void test_reschedule(void)
+{
+    reset(0);
+    evt_post_delayed(log_handler, (void *)'r', EVT_PRIO_NORMAL, 100, 0);
+    evt_post_delayed(log_handler, (void *)'r', EVT_PRIO_NORMAL, 500, 0);
+
+    advance(200);
+    evt_queue_process();
+    check_log("reschedule, moved", "");
+
+    advance(400);
+    evt_queue_process();
+    check_log("reschedule, once", "r");
+
+    evt_post_delayed(log_handler, (void *)'r', EVT_PRIO_NORMAL, 100, 0);
+    evt_cancel(log_handler, (void *)'r');
+    advance(200);
+    evt_queue_process();
+    check_log("cancel", "");
+}
+
+static void test_queue_full(void)
+{
+    reset(0);
+    for (uintptr_t i = 0; i < EVT_QUEUE_SIZE; i++)
+        check("queue full, fill", evt_post(log_handler, (void *)('A' + i), EVT_PRIO_LOW) == NRF_SUCCESS);
+    check("queue full", evt_post(log_handler, (void *)'z', EVT_PRIO_LOW) == NRF_ERROR_NO_MEM);
+    /* A pending pair is rescheduled in its slot. */
+    check("queue full, repost", evt_post(log_handler, (void *)'A', EVT_PRIO_LOW) == NRF_SUCCESS);
+    evt_queue_process();
+    m_log_len = 0;
+}
+
+static void test_slack_merge(void)
+{
+    reset(0);
+    /* Windows [100, 150] and [120, 130] ms share the wakeup at 130 ms. */
+    evt_post_delayed(log_handler, (void *)'a', EVT_PRIO_NORMAL, 100, 50);
+    evt_post_delayed(log_handler, (void *)'b', EVT_PRIO_NORMAL, 120, 10);
+    evt_queue_process();
+    check("slack merge, armed", m_timer_running && m_timer_ticks == TICKS(130));
+
+    advance(130);
+    evt_queue_process();
+    check_log("slack merge, one pass", "ab");
+    check("slack merge, idle timer", !m_timer_running);
+}
+
+static void test_periodic(void)
+{
+    reset(0);
+    evt_post_periodic(periodic_handler, (void *)'p', EVT_PRIO_NORMAL, 1000, 250);
+
+    /* Late runs within the slack keep the cadence of the original deadlines. Steps are
+     * multiples of 125 ms, a whole number of ticks. */
+    advance(1125);
+    evt_queue_process();
+    advance(1000);
+    evt_queue_process();
+    advance(875);
+    evt_queue_process();
+    check_log("periodic", "ppp");
+
+    /* Missing several periods runs the event once and restarts the cadence. */
+    advance(5500);
+    evt_queue_process();
+    check_log("periodic, missed", "p");
+    advance(875);
+    evt_queue_process();
+    check_log("periodic, restarted early", "");
+    advance(125);
+    evt_queue_process();
+    check_log("periodic, restarted", "p");
+
+    evt_cancel(periodic_handler, (void *)'p');
+}
+
+static void test_counter_wrap(void)
+{
+    reset(RTC_MASK - TICKS(50));
+    evt_post_delayed(log_handler, (void *)'b', EVT_PRIO_NORMAL, 200, 0);
+    evt_post_delayed(log_handler, (void *)'a', EVT_PRIO_NORMAL, 100, 0);
+    evt_queue_process();
+    check_log("counter wrap, nothing due", "");
+    check("counter wrap, armed", m_timer_running && m_timer_ticks == TICKS(100));
+
+    advance(250);
+    evt_queue_process();
+    check_log("counter wrap", "ab");
+}
+
+static void test_invalid(void)
+{
+    reset(0);
+    check("null handler", evt_post(NULL, NULL, EVT_PRIO_LOW) == NRF_ERROR_NULL);
+    check("delay too long", evt_post_delayed(log_handler, NULL, EVT_PRIO_LOW, EVT_QUEUE_MAX_DELAY_MS, 1) ==
+          NRF_ERROR_INVALID_PARAM);
+    check("zero period", evt_post_periodic(log_handler, NULL, EVT_PRIO_LOW, 0, 0) == NRF_ERROR_INVALID_PARAM);
+}
+
+int main(void)
+{
+    test_priority_order();
+    test_deadline_order();
+    test_reschedule();
+    test_queue_full();
+    test_slack_merge();
+    test_periodic();
+    test_counter_wrap();
+    test_invalid();
+
+    if (m_failures != 0) {
+        printf("%u failures\n", m_failures);
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,11 @@
+/* Host shim for building SDK independent modules with tools/host tests. */
+#ifndef NORDIC_COMMON_H__
+#define NORDIC_COMMON_H__
+
+#define MIN(a, b)               ((a) < (b) ? (a) : (b))
+#define MAX(a, b)               ((a) < (b) ? (b) : (a))
+#define CONCAT_2_(p1, p2)       p1##p2
+#define CONCAT_2(p1, p2)        CONCAT_2_(p1, p2)
+#define STATIC_ASSERT(cond)     _Static_assert(cond, #cond)
+
+#endif // NORDIC_COMMON_H__
@@ -0,0 +1,7 @@
+/* Host shim for building SDK independent modules with tools/host tests. */
+#ifndef NRF_H
+#define NRF_H
+
+#define __DMB()     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#endif // NRF_H
@@ -0,0 +1,15 @@
+/* Host shim for building SDK independent modules with tools/host tests. */
+#ifndef NRF_ATOMIC_H__
+#define NRF_ATOMIC_H__
+
+#include <stdint.h>
+
+typedef volatile uint32_t nrf_atomic_u32_t;
+
+static inline uint32_t nrf_atomic_u32_store(nrf_atomic_u32_t * p_data, uint32_t value)
+{
+    __atomic_store_n(p_data, value, __ATOMIC_RELEASE);
+    return value;
+}
+
+#endif // NRF_ATOMIC_H__
@@ -0,0 +1,19 @@
+/* Host shim for building SDK independent modules with tools/host tests. The counter and its
+ * overflow event are implemented by the test. */
+#ifndef NRF_RTC_H__
+#define NRF_RTC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    NRF_RTC_EVENT_OVERFLOW,
+} nrf_rtc_event_t;
+
+#define NRF_RTC1                ((void *)1)
+
+uint32_t nrf_rtc_counter_get(void * p_reg);
+bool     nrf_rtc_event_pending(void * p_reg, nrf_rtc_event_t event);
+void     nrf_rtc_event_clear(void * p_reg, nrf_rtc_event_t event);
+
+#endif // NRF_RTC_H__
@@ -0,0 +1,14 @@
+/* Host shim for building SDK independent modules with tools/host tests. */
+#ifndef SDK_ERRORS_H__
+#define SDK_ERRORS_H__
+
+#include <stdint.h>
+
+typedef uint32_t ret_code_t;
+
+#define NRF_SUCCESS             0
+#define NRF_ERROR_NO_MEM        4
+#define NRF_ERROR_INVALID_PARAM 7
+#define NRF_ERROR_NULL          14
+
+#endif // SDK_ERRORS_H__
@@ -0,0 +1,101 @@
+/* Host stress test for spsc_ring: one producer thread pushes variable length frames as
+ * | len:8 | data |, the same way stdio_rx_handler() does, and the consumer checks every byte.
+ * A small ring keeps the indices wrapping and the producer hitting a full ring.
+ *
+ * Build and run from the repository root:
+ *     gcc -std=gnu11 -O2 -Wall -pthread -I tools/host -I . \
+ *         tools/host/spsc_ring_test.c spsc_ring.c -o spsc_ring_test && ./spsc_ring_test
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "spsc_ring.h"
+
+#define FRAMES          2000000
+#define FRAME_MAX_LEN   40
+
+SPSC_RING_DEF(m_ring, 64);
+
+static uint8_t frame_len(uint32_t seq)
+{
+    return 1 + (seq * 7) % FRAME_MAX_LEN;
+}
+
+static void * producer(void * p_arg)
+{
+    uint8_t data[FRAME_MAX_LEN];
+
+    for (uint32_t seq = 0; seq < FRAMES; ) {
+        uint8_t len = frame_len(seq);
+
+        for (uint8_t i = 0; i < len; i++)
+            data[i] = (uint8_t)(seq + i);
+
+        /* Odd frames go through the single buffer push. */
+        if (seq & 1) {
+            uint8_t frame[1 + FRAME_MAX_LEN];
+            frame[0] = len;
+            for (uint8_t i = 0; i < len; i++)
+                frame[1 + i] = data[i];
+            if (spsc_ring_push(&m_ring, frame, 1 + len) != NRF_SUCCESS) {
+                sched_yield();
+                continue;
+            }
+        } else if (spsc_ring_push2(&m_ring, &len, sizeof(len), data, len) != NRF_SUCCESS) {
+            sched_yield();
+            continue;
+        }
+        seq++;
+    }
+
+    return NULL;
+}
+
+static void pop_all(uint8_t * p_data, uint32_t len)
+{
+    uint32_t got = 0;
+
+    while (got < len) {
+        uint32_t n = spsc_ring_pop(&m_ring, p_data + got, len - got);
+        if (n == 0)
+            sched_yield();
+        got += n;
+    }
+}
+
+int main(void)
+{
+    pthread_t thread;
+    uint8_t   data[FRAME_MAX_LEN];
+    uint8_t   len;
+
+    pthread_create(&thread, NULL, producer, NULL);
+
+    for (uint32_t seq = 0; seq < FRAMES; seq++) {
+        pop_all(&len, sizeof(len));
+        if (len != frame_len(seq)) {
+            printf("frame %u: length %u, expected %u\n", seq, len, frame_len(seq));
+            return 1;
+        }
+
+        pop_all(data, len);
+        for (uint8_t i = 0; i < len; i++) {
+            if (data[i] != (uint8_t)(seq + i)) {
+                printf("frame %u: byte %u is %02x, expected %02x\n", seq, i, data[i],
+                       (uint8_t)(seq + i));
+                return 1;
+            }
+        }
+    }
+
+    pthread_join(thread, NULL);
+    if (spsc_ring_used(&m_ring) != 0) {
+        printf("%u bytes left in the ring\n", spsc_ring_used(&m_ring));
+        return 1;
+    }
+
+    printf("ok, %u frames\n", FRAMES);
+    return 0;
+}
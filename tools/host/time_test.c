@@ -0,0 +1,194 @@
+/* Host test for time.c: ISO-8601 formatting against the C library, slewed and stepped phone
+ * syncs, and learning the drift of a slow 32 kHz clock. RTC1 is simulated below, its ticks run
+ * m_slow_ppb slower than true time.
+ *
+ * Build and run from the repository root:
+ *     gcc -std=gnu11 -O2 -Wall -Wno-unknown-pragmas -I tools/host -I . \
+ *         tools/host/time_test.c time.c -o time_test && ./time_test
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "nrf_rtc.h"
+#include "rtc_time.h"
+
+#define TICKS_PER_SEC       32768
+#define SYNC_INTERVAL_SEC   (3 * 86400)
+#define STEP_SEC            256             /* Below the 512 s RTC period, no overflow is missed. */
+
+volatile uint32_t rtc1_overflow_cnt;
+
+static uint64_t m_rtc_ticks;                /* Local clock. */
+static bool     m_overflow;
+static int64_t  m_true_sec;                 /* Phone time. */
+static int32_t  m_slow_ppb;
+static int64_t  m_lost_ppb_ticks;           /* Fraction of a tick not yet lost to m_slow_ppb. */
+static uint32_t m_failures;
+
+uint32_t nrf_rtc_counter_get(void * p_reg)
+{
+    return (uint32_t)m_rtc_ticks & 0x00FFFFFF;
+}
+
+bool nrf_rtc_event_pending(void * p_reg, nrf_rtc_event_t event)
+{
+    return m_overflow;
+}
+
+void nrf_rtc_event_clear(void * p_reg, nrf_rtc_event_t event)
+{
+    m_overflow = false;
+}
+
+static void check(const char * p_test, bool ok)
+{
+    if (!ok) {
+        printf("%s: failed\n", p_test);
+        m_failures++;
+    }
+}
+
+/* Advances true time, calling time() often enough to count every RTC overflow as the
+ * application does. */
+static void advance(uint32_t sec)
+{
+    while (sec > 0) {
+        uint32_t step = sec < STEP_SEC ? sec : STEP_SEC;
+        uint64_t old  = m_rtc_ticks;
+
+        m_lost_ppb_ticks += (int64_t)step * TICKS_PER_SEC * m_slow_ppb;
+        m_rtc_ticks      += (uint64_t)step * TICKS_PER_SEC - m_lost_ppb_ticks / 1000000000;
+        m_lost_ppb_ticks %= 1000000000;
+        if ((old >> 24) != (m_rtc_ticks >> 24))
+            m_overflow = true;
+
+        m_true_sec += step;
+        sec        -= step;
+        (void)time(NULL);
+    }
+}
+
+static void sync(int64_t phone_sec)
+{
+    time_t    t = (time_t)phone_sec;
+    struct tm tm;
+
+    gmtime_r(&t, &tm);
+    time_init(&tm);
+}
+
+static void test_iso8601(void)
+{
+    static const int64_t times[] = {
+        0, 59, 86399, 86400, 951782399, 951782400, 951868800, 1709164800, 2147483647,
+        4107542399, 4107542400, 4107628800,
+    };
+    char expected[32];
+    char buf[TIME_ISO8601_LEN];
+    bool ok = true;
+
+    /* Fixed dates around leap days, then a sweep that changes the cached day on every call. */
+    for (uint32_t i = 0; i < sizeof(times) / sizeof(times[0]) + 200000; i++) {
+        time_t    t = i < sizeof(times) / sizeof(times[0]) ? (time_t)times[i] :
+                      (time_t)(i * 86413LL % 4102444800LL);
+        struct tm tm;
+
+        gmtime_r(&t, &tm);
+        strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        if (time_iso8601(t, buf, sizeof(buf)) != TIME_ISO8601_LEN - 1 || strcmp(buf, expected) != 0) {
+            printf("iso8601: %lld gave %s, expected %s\n", (long long)t, buf, expected);
+            ok = false;
+            break;
+        }
+    }
+    check("iso8601", ok);
+    check("iso8601, short buffer", time_iso8601(0, buf, sizeof(buf) - 1) == 0);
+}
+
+static void test_slew(void)
+{
+    int64_t start;
+    bool    monotonic = true;
+
+    m_true_sec = 1767225600;                /* 2026-01-01 */
+    sync(m_true_sec);
+    check("slew, stepped from build time", time(NULL) == m_true_sec);
+
+    /* +10 s is slewed at 2 ms/s: no jump, 2 s after 1000 s, all of it after 5000 s. */
+    advance(100);
+    sync(m_true_sec + 10);
+    start = m_true_sec;
+    check("slew, no jump", time(NULL) == start);
+    advance(1000);
+    check("slew, partly absorbed", time(NULL) == start + 1000 + 2);
+    advance(4000);
+    check("slew, absorbed", time(NULL) == start + 5000 + 10);
+
+    /* -10 s relative to the device: time() must not go backwards while it is absorbed. */
+    sync(m_true_sec + 10 - 10);
+    start = time(NULL);
+    for (int i = 0; i < 6000; i++) {
+        time_t before = time(NULL);
+        advance(1);
+        monotonic = monotonic && time(NULL) >= before;
+    }
+    check("slew, monotonic", monotonic);
+    check("slew, negative absorbed", time(NULL) == m_true_sec);
+
+    /* More than 60 s is stepped at once. */
+    sync(m_true_sec + 100);
+    check("slew, stepped", time(NULL) == m_true_sec + 100);
+    m_true_sec += 100;
+}
+
+static void test_drift(void)
+{
+    int64_t error = 0;
+
+    /* The crystal is 15 ppm slow. Start from a stepped sync, the previous anchor is unrelated. */
+    m_slow_ppb = 15000;
+    m_true_sec += 365 * 86400;
+    sync(m_true_sec);
+
+    for (int i = 0; i < 30; i++) {
+        advance(SYNC_INTERVAL_SEC);
+        error = (int64_t)time(NULL) - m_true_sec;
+        sync(m_true_sec);
+    }
+
+    /* Uncorrected the clock would be 3.9 s behind at each sync. */
+    check("drift, learned", time_drift_ppb_get() > 13500 && time_drift_ppb_get() < 16500);
+    check("drift, corrected", error >= -1 && error <= 1);
+
+    /* A phone clock change of 25 s is no drift, it must not be learned. */
+    int32_t drift = time_drift_ppb_get();
+    advance(SYNC_INTERVAL_SEC);
+    sync(m_true_sec + 25);
+    check("drift, jump rejected", time_drift_ppb_get() == drift);
+    advance(SYNC_INTERVAL_SEC);
+    sync(m_true_sec);
+    check("drift, jump back rejected", time_drift_ppb_get() == drift);
+
+    /* A short baseline is not used either. */
+    advance(3600);
+    sync(m_true_sec);
+    check("drift, short interval ignored", time_drift_ppb_get() == drift);
+}
+
+int main(void)
+{
+    test_iso8601();
+    test_slew();
+    test_drift();
+
+    if (m_failures != 0) {
+        printf("%u failures\n", m_failures);
+        return 1;
+    }
+
+    printf("ok, drift %d ppb\n", time_drift_ppb_get());
+    return 0;
+}